@@ -0,0 +1,450 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Microbenchmarks of engine primitives
+ *
+ * Usage: benchmarks <irrlicht media path> [results.json]
+ *
+ * Engine benchmarks run headless on the null driver. Results are printed and optionally written as JSON with the
+ * median, minimum and mean time per operation of every benchmark so that they can be compared with a stored baseline.
+ */
+
+#include <irrlicht-engine/engine.h>
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using timer = std::chrono::steady_clock;
+
+const timer::duration failed = timer::duration(-1);  // returned by a batch that could not be run
+const timer::duration min_time = std::chrono::milliseconds(200);
+const std::size_t min_samples = 5;
+const std::size_t max_samples = 1000;
+
+template<typename T>
+void do_not_optimize(T& value)
+{
+#if _MSC_VER
+  static void* volatile sink;
+  sink = &value;
+#else
+  asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+double nanoseconds(timer::duration d) { return std::chrono::duration<double, std::nano>(d).count(); }
+
+/**
+ * Repeats measured batches of operations and collects time per operation
+ */
+class harness {
+public:
+  /**
+   * Runs a benchmark
+   *
+   * Batches are repeated at least @c min_samples times and until they take @c min_time in total, but never more than
+   * @c max_batches times.
+   *
+   * @param name         Benchmark name
+   * @param batch_size   Number of operations in a batch
+   * @param batch        Callable taking the batch size and returning measured time of the batch or @c failed
+   * @param max_batches  Limit of batches for operations with lasting side effects
+   *
+   * @return Status
+   */
+  template<typename Batch>
+  bool run(const std::string& name, std::size_t batch_size, Batch batch, std::size_t max_batches = max_samples);
+
+  /**
+   * Writes results to a JSON file
+   *
+   * @param path Output file
+   *
+   * @return Status
+   */
+  bool write(const std::string& path) const;
+
+private:
+  struct result {
+    std::string name;        /// benchmark name
+    std::size_t iterations;  /// number of measured operations
+    double median_ns;        /// median time per operation
+    double min_ns;           /// time per operation of the fastest batch
+    double mean_ns;          /// mean time per operation
+  };
+
+  std::vector<result> results_;  /// finished benchmarks
+};
+
+template<typename Batch>
+bool harness::run(const std::string& name, std::size_t batch_size, Batch batch, std::size_t max_batches)
+{
+  // batches measure their own time so that set-up and clean-up are not included
+  std::vector<double> samples;
+  timer::duration total = timer::duration::zero();
+  while (samples.size() < max_batches && (samples.size() < min_samples || total < min_time)) {
+    const timer::duration elapsed = batch(batch_size);
+    if (elapsed == failed) {
+      std::cerr << name << ": FAILED\n";
+      return false;
+    }
+    total += elapsed;
+    samples.push_back(nanoseconds(elapsed) / batch_size);
+  }
+
+  std::sort(samples.begin(), samples.end());
+  const std::size_t iterations = samples.size() * batch_size;
+  results_.push_back({name, iterations, samples[samples.size() / 2], samples.front(), nanoseconds(total) / iterations});
+  std::printf("%-45s %14.1f ns %12zu\n", name.c_str(), results_.back().median_ns, iterations);
+  return true;
+}
+
+bool harness::write(const std::string& path) const
+{
+  std::ofstream file(path);
+  if (!file) return false;
+
+  char date[32];
+  const std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+#ifdef NDEBUG
+  const char* const build = "release";
+#else
+  const char* const build = "debug";
+#endif
+
+  file << "{\n\"context\":{\"date\":\"" << date << "\",\"build\":\"" << build << "\",\"driver\":\"null\"},\n";
+  file << "\"benchmarks\":[";
+  bool first = true;
+  for (const result& r : results_) {
+    if (!first) file << ",";
+    first = false;
+    file << "\n{\"name\":\"" << r.name << "\",\"iterations\":" << r.iterations << ",\"time_unit\":\"ns\""
+         << ",\"median\":" << r.median_ns << ",\"min\":" << r.min_ns << ",\"mean\":" << r.mean_ns << "}";
+  }
+  file << "\n]}\n";
+
+  return static_cast<bool>(file);
+}
+
+/* ********************************* T Y P E   C O U N T E R S ********************************* */
+
+struct counted : workshop::type_counters<counted> {
+  int value = 0;
+};
+
+struct plain {
+  int value = 0;
+};
+
+template<typename T>
+timer::duration construct_batch(std::size_t n)
+{
+  const timer::time_point begin = timer::now();
+  for (std::size_t i = 0; i < n; ++i) {
+    T t;
+    do_not_optimize(t);
+  }
+  return timer::now() - begin;
+}
+
+template<typename T>
+timer::duration copy_batch(std::size_t n)
+{
+  T source;
+  const timer::time_point begin = timer::now();
+  for (std::size_t i = 0; i < n; ++i) {
+    T t(source);
+    do_not_optimize(t);
+  }
+  return timer::now() - begin;
+}
+
+template<typename T>
+timer::duration move_batch(std::size_t n)
+{
+  T source;
+  const timer::time_point begin = timer::now();
+  for (std::size_t i = 0; i < n; ++i) {
+    T t(std::move(source));
+    do_not_optimize(t);
+  }
+  return timer::now() - begin;
+}
+
+timer::duration add_counters_batch(std::size_t n)
+{
+  // every registration stays in the registry for the rest of the run, so the number of batches is bounded by the
+  // caller and fresh names are made before the measurement
+  static std::size_t registered = 0;
+  std::vector<std::string> names(n);
+  for (std::string& name : names) name = "benchmark entry " + std::to_string(registered++);
+
+  const timer::time_point begin = timer::now();
+  for (const std::string& name : names) do_not_optimize(workshop::counters::instance().add(name));
+  return timer::now() - begin;
+}
+
+/* ********************************* E N G I N E ********************************* */
+
+const char* const type_names[workshop::object_handle::type_num] = {"faerie", "ninja", "dwarf", "yodan"};
+
+/**
+ * Headless engine with the level, camera, laser and font
+ */
+class scene : workshop::immovable {
+public:
+  explicit scene(const std::string& irrlicht_media_path);
+  ~scene();
+
+  bool ready() const { return ready_; }
+  workshop::engine& engine() { return engine_; }
+  std::size_t objects() const { return objects_.size(); }
+
+  /**
+   * Creates object owned by the scene
+   *
+   * @param t Object type
+   *
+   * @return Created object or @c nullptr on failure
+   */
+  workshop::object_handle* create(workshop::object_handle::type t);
+
+  /**
+   * Creates object with a selector in front of the camera
+   *
+   * @param t Object type
+   *
+   * @return Created object or @c nullptr on failure
+   */
+  workshop::object_handle* add(workshop::object_handle::type t);
+
+  /**
+   * Spawns object owned by the scene and runs frames until the engine creates it
+   *
+   * @param t         Object type
+   * @param spawn_ms  Time the engine spent creating the object at the end of a frame
+   *
+   * @return Created object or @c nullptr on failure
+   */
+  workshop::object_handle* spawn(workshop::object_handle::type t, float* spawn_ms);
+
+  /**
+   * Runs a single frame
+   *
+   * @return Status
+   */
+  bool frame() { return engine_.run() && engine_.begin_scene() && engine_.end_scene(); }
+
+private:
+  workshop::engine::device_type type_;             /// null driver
+  workshop::engine engine_;                        /// benchmarked engine
+  workshop::camera* camera_;                       /// engine camera
+  std::vector<workshop::object_handle*> objects_;  /// created objects
+  bool ready_;                                     /// engine was initialized
+};
+
+scene::scene(const std::string& irrlicht_media_path) :
+    type_(workshop::engine::device_null), engine_(irrlicht_media_path, &type_), camera_(nullptr), ready_(false)
+{
+  ready_ = engine_.internal_event_receiver_create() && engine_.init_device(640, 480, 32, false, false, false) == 0 &&
+           engine_.font() && engine_.add_laser() && engine_.create_camera(&camera_) == 0;
+  if (!ready_) return;
+  camera_->position(50, 50, -60);
+  camera_->target(-70, 30, -60);
+}
+
+scene::~scene()
+{
+  for (workshop::object_handle* object : objects_) delete object;
+}
+
+workshop::object_handle* scene::create(workshop::object_handle::type t)
+{
+  const std::string name = type_names[t];
+  workshop::object_handle* object = new (std::nothrow) workshop::object_handle(t, &name);
+  if (!object) return nullptr;
+  objects_.push_back(object);
+  return object->resource_set(&engine_) ? object : nullptr;
+}
+
+workshop::object_handle* scene::add(workshop::object_handle::type t)
+{
+  workshop::object_handle* object = create(t);
+  if (!object) return nullptr;
+
+  workshop::selector s;
+  if (s.init(&engine_, object) != SELECTOR_INIT_SUCCESS) return nullptr;
+  object->selector(&s);
+
+  // rows of objects standing on the floor across the laser
+  const int i = static_cast<int>(objects_.size()) - 1;
+  object->position(-100.f - 30.f * static_cast<float>(i / 10), -66.f, -210.f + 30.f * static_cast<float>(i % 10));
+  return object;
+}
+
+workshop::object_handle* scene::spawn(workshop::object_handle::type t, float* spawn_ms)
+{
+  // the operation is awaited by hand, the engine resumes a no-op coroutine once the object is created
+  workshop::spawn_operation operation = engine_.spawn_async(t, type_names[t]);
+  *spawn_ms = 0.f;
+  if (operation.await_suspend(std::noop_coroutine())) {
+    const int max_frames = 1000;
+    int frame = 0;
+    for (; frame < max_frames; ++frame) {
+      if (!this->frame()) return nullptr;
+      if (engine_.stats().last().spawns > 0) break;
+    }
+    if (frame == max_frames) return nullptr;
+    *spawn_ms = engine_.stats().last().phase_ms[workshop::frame_stats::phase_spawn];
+  }
+
+  workshop::object_handle* object = operation.await_resume();
+  if (object) objects_.push_back(object);
+  return object;
+}
+
+bool run_engine_benchmarks(harness& h, scene& s)
+{
+  using workshop::object_handle;
+
+  for (int t = 0; t < object_handle::type_num; ++t) {
+    object_handle* object = s.add(static_cast<object_handle::type>(t));
+    if (!object) return false;
+    const bool ok = h.run(std::string("selector::init/") + type_names[t], 10, [&](std::size_t n) {
+      timer::duration total = timer::duration::zero();
+      for (std::size_t i = 0; i < n; ++i) {
+        workshop::selector selector;
+        const timer::time_point begin = timer::now();
+        const int status = selector.init(&s.engine(), object);
+        total += timer::now() - begin;
+        if (status != SELECTOR_INIT_SUCCESS) return failed;
+      }
+      return total;
+    });
+    if (!ok) return false;
+  }
+
+  // picking time is measured by the engine around a single ray cast per frame, counts include objects created above
+  for (const std::size_t count : {10, 100, 1000}) {
+    while (s.objects() < count)
+      if (!s.add(object_handle::type_ninja)) return false;
+    const bool ok = h.run("engine::process_collisions/" + std::to_string(count), 10, [&](std::size_t n) {
+      std::chrono::duration<double, std::milli> total(0);
+      for (std::size_t i = 0; i < n; ++i) {
+        if (!s.frame()) return failed;
+        total += std::chrono::duration<double, std::milli>(
+          s.engine().stats().last().phase_ms[workshop::frame_stats::phase_picking]);
+      }
+      return std::chrono::duration_cast<timer::duration>(total);
+    });
+    if (!ok) return false;
+  }
+
+  // labels are queued during the frame and drawn by end_scene(), which the engine measures as the present phase
+  const bool ok = h.run("engine::draw_label", 100, [&](std::size_t n) {
+    if (!s.engine().run() || !s.engine().begin_scene()) return failed;
+    const timer::time_point begin = timer::now();
+    for (std::size_t i = 0; i < n; ++i) s.engine().draw_label("Benchmark label");
+    const timer::duration queued = timer::now() - begin;
+    if (!s.engine().end_scene()) return failed;
+    const std::chrono::duration<double, std::milli> present(
+      s.engine().stats().last().phase_ms[workshop::frame_stats::phase_present]);
+    return queued + std::chrono::duration_cast<timer::duration>(present);
+  });
+  if (!ok) return false;
+
+  // the hitch is the spawn phase of the frame completing the operation, the first spawn of a type parses its mesh
+  for (int t = 0; t < object_handle::type_num; ++t) {
+    const bool ok = h.run(
+      std::string("engine::spawn_async/") + type_names[t], 1,
+      [&](std::size_t n) {
+        std::chrono::duration<double, std::milli> total(0);
+        for (std::size_t i = 0; i < n; ++i) {
+          float spawn_ms = 0.f;
+          if (!s.spawn(static_cast<object_handle::type>(t), &spawn_ms)) return failed;
+          total += std::chrono::duration<double, std::milli>(spawn_ms);
+        }
+        return std::chrono::duration_cast<timer::duration>(total);
+      },
+      min_samples);
+    if (!ok) return false;
+  }
+
+  // every created object stays in the scene so this one runs last
+  for (int t = 0; t < object_handle::type_num; ++t) {
+    const bool ok = h.run(std::string("object_handle::resource_set/") + type_names[t], 10, [&](std::size_t n) {
+      const timer::time_point begin = timer::now();
+      for (std::size_t i = 0; i < n; ++i)
+        if (!s.create(static_cast<object_handle::type>(t))) return failed;
+      return timer::now() - begin;
+    });
+    if (!ok) return false;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " <irrlicht media path> [results.json]\n";
+    return 1;
+  }
+
+  harness h;
+  h.run("type_counters/construct", 1000, construct_batch<counted>);
+  h.run("type_counters/copy", 1000, copy_batch<counted>);
+  h.run("type_counters/move", 1000, move_batch<counted>);
+  h.run("plain/construct", 1000, construct_batch<plain>);
+  h.run("plain/copy", 1000, copy_batch<plain>);
+  h.run("plain/move", 1000, move_batch<plain>);
+  h.run("counters::add", 100, add_counters_batch, min_samples);
+
+  {
+    scene s(argv[1]);
+    if (!s.ready()) {
+      std::cerr << "Engine initialization failed\n";
+      return 2;
+    }
+    if (!run_engine_benchmarks(h, s)) return 3;
+  }
+
+  if (argc == 3 && !h.write(argv[2])) {
+    std::cerr << "Cannot write " << argv[2] << "\n";
+    return 4;
+  }
+  return 0;
+}
@@ -42,6 +42,7 @@ class Engine3dConan(ConanFile):
     exports_sources = [
         "include*",
         "src*",
+        "benchmarks*",
         "CMakeLists.txt",
         "irrlicht-engine-config.cmake.in",
     ]
@@ -90,4 +91,6 @@ class Engine3dConan(ConanFile):
 
     def package_info(self):
         self.cpp_info.libs = ["irrlicht-engine"]
+        if self.settings.os in ["Linux", "FreeBSD"]:
+            self.cpp_info.system_libs = ["pthread"]
         self.cpp_info.set_property("cmake_target_name", "irrlicht::engine")
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+#include <vector>
+
+namespace workshop {
+
+/**
+ * @brief Dynamic AABB tree
+ *
+ * Incrementally updated bounding volume hierarchy used for spatial queries over engine objects. Leaves store boxes
+ * enlarged by a margin so that small movements do not change the tree. New leaves are inserted next to the sibling
+ * that gives the smallest increase of surface area and the tree is kept balanced with rotations.
+ */
+class aabb_tree : type_counters<aabb_tree> {
+public:
+  static constexpr int null_node = -1;
+
+  /**
+   * Constructor
+   *
+   * @param margin Enlargement of leaf boxes
+   */
+  explicit aabb_tree(irr::f32 margin);
+
+  /**
+   * Creates a proxy
+   *
+   * @param box        Tight bounding box
+   * @param user_data  Data returned by queries
+   *
+   * @return Proxy id
+   */
+  int insert(const irr::core::aabbox3df& box, void* user_data);
+
+  /**
+   * Destroys a proxy
+   *
+   * @param proxy Proxy id
+   */
+  void remove(int proxy);
+
+  /**
+   * Updates proxy bounding box
+   *
+   * @param proxy  Proxy id
+   * @param box    New tight bounding box
+   *
+   * @return @c true if the proxy had to be reinserted
+   */
+  bool move(int proxy, const irr::core::aabbox3df& box);
+
+  /**
+   * Updates bounding boxes of all proxies
+   *
+   * @param box Callable taking proxy user data and returning its current tight bounding box
+   *
+   * @return Number of proxies that had to be reinserted
+   */
+  template<typename Box>
+  int refit(Box box);
+
+  void* user_data(int proxy) const;
+  int height() const { return root_ == null_node ? 0 : nodes_[root_].height; }
+
+  /**
+   * Visits all proxies whose enlarged box passes the overlap test
+   *
+   * @param overlap  Callable taking @c irr::core::aabbox3df and returning @c true if the box may contain results
+   * @param visit    Callable taking proxy user data, returns @c false to stop the query
+   */
+  template<typename Overlap, typename Visitor>
+  void query(Overlap overlap, Visitor visit) const;
+
+private:
+  struct node {
+    irr::core::aabbox3df box;  /// enlarged box of a leaf or union of children boxes
+    void* user_data;           /// leaf data
+    int parent;                /// parent node or next free node
+    int child1;                /// first child or null_node for leaves
+    int child2;                /// second child
+    int height;                /// leaf is 0, free node is -1
+    bool leaf() const { return child1 == null_node; }
+  };
+
+  tracked_vector<node> nodes_;         /// node pool
+  int root_;                           /// root node
+  int free_list_;                      /// first free node in the pool
+  irr::f32 margin_;                    /// leaf box enlargement
+  mutable tracked_vector<int> stack_;  /// traversal stack reused between queries
+
+  int allocate();
+  void release(int index);
+  void insert_leaf(int leaf);
+  void remove_leaf(int leaf);
+  int balance(int index);
+};
+
+template<typename Box>
+int aabb_tree::refit(Box box)
+{
+  // reinserted leaves keep their indices so every proxy is visited once
+  int reinserted = 0;
+  for (int i = 0; i < static_cast<int>(nodes_.size()); ++i)
+    if (nodes_[i].height == 0 && move(i, box(nodes_[i].user_data))) ++reinserted;
+  return reinserted;
+}
+
+template<typename Overlap, typename Visitor>
+void aabb_tree::query(Overlap overlap, Visitor visit) const
+{
+  if (root_ == null_node) return;
+
+  stack_.clear();
+  stack_.push_back(root_);
+  while (!stack_.empty()) {
+    const node& n = nodes_[stack_.back()];
+    stack_.pop_back();
+    if (!overlap(n.box)) continue;
+    if (n.leaf()) {
+      if (!visit(n.user_data)) return;
+    } else {
+      stack_.push_back(n.child1);
+      stack_.push_back(n.child2);
+    }
+  }
+}
+
+}  // namespace workshop
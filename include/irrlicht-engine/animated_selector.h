@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+
+namespace workshop {
+
+/**
+ * @brief Triangle selector following the animation of a node
+ *
+ * Triangles are kept in the space of the mesh and refitted in place to the current animation frame of the node.
+ * A refit happens only when triangles are requested for a frame different from the refitted one, so characters which
+ * are not hit by any ray keep their triangles untouched and a new selector copies no triangles at all. Ray tests check
+ * the bounding box of the node before any triangle is refitted or tested.
+ *
+ * Each character holds its own selector through @c setTriangleSelector(), so the selector never outlives the node
+ * and keeps a plain pointer to it.
+ */
+class animated_selector : public irr::scene::ITriangleSelector, type_counters<animated_selector> {
+public:
+  using triangle_storage = tracked_vector<irr::core::triangle3df, memory_counters::object_selectors>;
+
+  /**
+   * Constructor, triangles are counted but not copied until they are first requested
+   *
+   * @param node Animated node to select triangles of
+   */
+  explicit animated_selector(irr::scene::IAnimatedMeshSceneNode* node);
+
+  /**
+   * Constructor restoring triangles refitted earlier, nothing is refitted until the node leaves their frame
+   *
+   * @param node       Animated node to select triangles of
+   * @param triangles  Mesh space triangles of the frame
+   * @param frame      Refitted frame
+   */
+  animated_selector(irr::scene::IAnimatedMeshSceneNode* node, triangle_storage&& triangles, irr::f32 frame);
+
+  /**
+   * Updates triangles to the current animation frame of the node
+   */
+  void refit() const;
+
+  const triangle_storage& triangles() const { return triangles_; }
+  irr::f32 frame() const { return frame_; }
+
+  /**
+   * Finds the nearest intersection of a ray with the triangles
+   *
+   * @param ray       World space ray
+   * @param point     Nearest intersection point in world space
+   * @param triangle  Hit triangle in world space
+   *
+   * @return @c true if the ray hits any triangle
+   */
+  bool intersect(const irr::core::line3df& ray, irr::core::vector3df* point, irr::core::triangle3df* triangle) const;
+
+  // irr::scene::ITriangleSelector
+  irr::s32 getTriangleCount() const override { return static_cast<irr::s32>(count_); }
+  void getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size, irr::s32& out_triangle_count,
+                    const irr::core::matrix4* transform = 0) const override;
+  void getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size, irr::s32& out_triangle_count,
+                    const irr::core::aabbox3d<irr::f32>& box, const irr::core::matrix4* transform = 0) const override;
+  void getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size, irr::s32& out_triangle_count,
+                    const irr::core::line3d<irr::f32>& line, const irr::core::matrix4* transform = 0) const override;
+  irr::scene::ISceneNode* getSceneNodeForTriangle(irr::u32) const override { return node_; }
+  irr::u32 getSelectorCount() const override { return 1; }
+  irr::scene::ITriangleSelector* getSelector(irr::u32 index) override { return index == 0 ? this : nullptr; }
+  const irr::scene::ITriangleSelector* getSelector(irr::u32 index) const override
+  {
+    return index == 0 ? this : nullptr;
+  }
+
+private:
+  irr::scene::IAnimatedMeshSceneNode* node_;  /// selected node
+  mutable triangle_storage triangles_;        /// mesh space triangles of the refitted frame
+  mutable irr::f32 frame_;                    /// refitted frame, negative before the first refit
+  mutable std::size_t count_;                 /// triangles of the mesh, known before the first refit
+};
+
+}  // namespace workshop
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace workshop {
+
+/**
+ * @brief Files to be read in the background
+ */
+struct load_request {
+  std::vector<std::string> paths;           /// files to read
+  std::vector<std::vector<char>> contents;  /// file contents, empty if a file could not be read
+  void* user_data;                          /// data of the requester
+};
+
+/**
+ * @brief Background file reader
+ *
+ * Worker threads read whole files into memory so that the main thread only has to parse them. Irrlicht is not
+ * thread-safe so nothing but plain file I/O is done on the workers.
+ */
+class async_loader : immovable, type_counters<async_loader> {
+public:
+  async_loader();
+  ~async_loader();
+
+  /**
+   * Starts worker threads
+   *
+   * @param workers Number of worker threads
+   *
+   * @return Status
+   */
+  [[nodiscard]] bool start(unsigned workers);
+
+  /**
+   * Stops worker threads, requests that were not completed yet are abandoned
+   */
+  void stop();
+
+  bool active() const { return !workers_.empty(); }
+
+  /**
+   * Queues request to be read
+   *
+   * @param request Request that has to stay valid until it is returned by @c completed()
+   */
+  void submit(load_request* request);
+
+  /**
+   * Returns request whose files were read
+   *
+   * @return Completed request or nullptr if there is none
+   */
+  load_request* completed();
+
+private:
+  std::vector<std::thread> workers_;   /// worker threads
+  std::deque<load_request*> pending_;  /// requests waiting for a worker
+  std::deque<load_request*> done_;     /// requests waiting for the main thread
+  bool stopping_;                      /// workers should exit
+  std::mutex mutex_;                   /// guards pending_, done_ and stopping_
+  std::condition_variable ready_;      /// signals new requests and stop requests
+
+  void run();
+};
+
+}  // namespace workshop
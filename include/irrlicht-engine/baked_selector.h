@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+
+namespace workshop {
+
+/**
+ * @brief Triangle selector over static triangles baked into clusters
+ *
+ * Triangles are kept in the space of the mesh, sorted along a Morton curve and split into clusters of up to
+ * @c cluster_size triangles with their bounding boxes. Box and line queries test cluster boxes before any triangle.
+ * The baked data is plain arrays so that it can be stored in a snapshot and restored without rebuilding anything.
+ *
+ * Used for the level. The collision resolver may keep the selector alive after the level node is gone, so no
+ * triangles should be requested once the level has been removed from the scene.
+ */
+class baked_selector : public irr::scene::ITriangleSelector, type_counters<baked_selector> {
+public:
+  static constexpr irr::u32 cluster_size = 128;
+
+  struct cluster {
+    irr::core::aabbox3df box;  /// mesh space bounding box of the triangles
+    irr::u32 first;            /// index of the first triangle
+    irr::u32 count;            /// number of triangles
+  };
+
+  struct data {
+    tracked_vector<irr::core::triangle3df, memory_counters::level_selector> triangles;  /// mesh space triangles
+    tracked_vector<cluster, memory_counters::level_selector> clusters;                 /// clusters in triangle order
+  };
+
+  /**
+   * Bakes triangles of a mesh
+   *
+   * @param mesh Static mesh
+   * @param out  Baked triangles and clusters
+   */
+  static void bake(const irr::scene::IMesh* mesh, data* out);
+
+  /**
+   * Constructor
+   *
+   * @param node   Node to select triangles of
+   * @param baked  Triangles and clusters baked from the mesh of the node
+   */
+  baked_selector(irr::scene::ISceneNode* node, data&& baked);
+
+  const data& baked() const { return data_; }
+
+  // irr::scene::ITriangleSelector
+  irr::s32 getTriangleCount() const override { return static_cast<irr::s32>(data_.triangles.size()); }
+  void getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size, irr::s32& out_triangle_count,
+                    const irr::core::matrix4* transform = 0) const override;
+  void getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size, irr::s32& out_triangle_count,
+                    const irr::core::aabbox3d<irr::f32>& box, const irr::core::matrix4* transform = 0) const override;
+  void getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size, irr::s32& out_triangle_count,
+                    const irr::core::line3d<irr::f32>& line, const irr::core::matrix4* transform = 0) const override;
+  irr::scene::ISceneNode* getSceneNodeForTriangle(irr::u32) const override { return node_; }
+  irr::u32 getSelectorCount() const override { return 1; }
+  irr::scene::ITriangleSelector* getSelector(irr::u32 index) override { return index == 0 ? this : nullptr; }
+  const irr::scene::ITriangleSelector* getSelector(irr::u32 index) const override
+  {
+    return index == 0 ? this : nullptr;
+  }
+
+private:
+  irr::scene::ISceneNode* node_;  /// selected node
+  data data_;                     /// baked triangles and clusters
+};
+
+}  // namespace workshop
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+#include <vector>
+
+namespace workshop {
+
+/**
+ * @brief Swept ellipsoid collision resolver
+ *
+ * @c collision_world makes the camera and moving characters (agents) slide along the level instead of passing
+ * through it. Every frame each agent is swept from its last resolved position to the position set by the user or
+ * camera controls. Candidate triangles are fetched from the level octree selector once per agent and frame, stored
+ * in ellipsoid space as structure of arrays and filtered with branch-free plane tests before the exact
+ * sphere-vs-triangle test. The response follows "Improved Collision detection and Response" by Kasper Fauerby, as
+ * the Irrlicht collision response animator does.
+ */
+class collision_world : type_counters<collision_world> {
+public:
+  collision_world();
+  ~collision_world();
+
+  /**
+   * Sets the level to collide with
+   *
+   * @param selector Level triangle selector (spatial index)
+   */
+  void level(irr::scene::ITriangleSelector* selector);
+
+  /**
+   * Registers collision-aware agent
+   *
+   * @param node         Scene node to move
+   * @param radius       Ellipsoid radius
+   * @param gravity      Gravity per second
+   * @param translation  Offset of the node position from the ellipsoid center
+   *
+   * @return Status
+   */
+  bool add(irr::scene::ISceneNode* node, const irr::core::vector3df& radius, const irr::core::vector3df& gravity,
+           const irr::core::vector3df& translation);
+
+  /**
+   * Unregisters agent
+   *
+   * @param node Scene node of the agent
+   */
+  void remove(irr::scene::ISceneNode* node);
+
+  /**
+   * Makes agent jump if it stands on the ground
+   *
+   * @param node   Scene node of the agent
+   * @param speed  Jump speed
+   */
+  void jump(irr::scene::ISceneNode* node, irr::f32 speed);
+
+  /**
+   * Resolves movement of all agents done since the last update
+   *
+   * @param time_ms Current time in milliseconds
+   */
+  void update(irr::u32 time_ms);
+
+private:
+  struct agent {
+    irr::scene::ISceneNode* node;           /// moved scene node
+    irr::core::vector3df radius;            /// ellipsoid radius
+    irr::core::vector3df gravity;           /// gravity per second
+    irr::core::vector3df translation;       /// node position relative to the ellipsoid center
+    irr::core::vector3df last_position;     /// last resolved node position
+    irr::core::vector3df falling_velocity;  /// velocity accumulated by gravity
+    irr::u32 last_time;                     /// time of the last update
+    bool falling;                           /// agent is in the air
+    bool first_update;                      /// position was not resolved yet
+  };
+
+  /// Triangles of the current query in ellipsoid space (structure of arrays)
+  struct triangle_soa {
+    tracked_vector<irr::f32> ax, ay, az;  /// vertex A
+    tracked_vector<irr::f32> bx, by, bz;  /// vertex B
+    tracked_vector<irr::f32> cx, cy, cz;  /// vertex C
+    tracked_vector<irr::f32> nx, ny, nz;  /// unit plane normal
+    tracked_vector<irr::f32> d;           /// plane distance
+    tracked_vector<irr::f32> t0;          /// earliest possible contact time or sentinel if plane is not touched
+    irr::u32 size;                        /// number of valid triangles
+  };
+
+  irr::scene::ITriangleSelector* level_;              /// level spatial index
+  tracked_vector<agent> agents_;                      /// registered agents
+  tracked_vector<irr::core::triangle3df> triangles_;  /// broadphase query buffer
+  triangle_soa soa_;                                  /// narrowphase working set
+
+  void resolve(agent& a, irr::u32 time_ms);
+  void gather(const irr::core::aabbox3df& box, const irr::core::vector3df& radius);
+  irr::core::vector3df collide(const irr::core::vector3df& position, const irr::core::vector3df& velocity, int depth,
+                               int& hits);
+  bool sweep(irr::u32 i, const irr::core::vector3df& base, const irr::core::vector3df& velocity, irr::f32& t,
+             irr::core::vector3df& point) const;
+};
+
+}  // namespace workshop
@@ -22,8 +22,22 @@
 
 #pragma once
 
+#include <irrlicht-engine/aabb_tree.h>
+#include <irrlicht-engine/animated_selector.h>
+#include <irrlicht-engine/async_loader.h>
+#include <irrlicht-engine/baked_selector.h>
+#include <irrlicht-engine/collision.h>
+#include <irrlicht-engine/frame_capture.h>
+#include <irrlicht-engine/frame_stats.h>
+#include <irrlicht-engine/input_log.h>
+#include <irrlicht-engine/render_queue.h>
+#include <irrlicht-engine/resolution_scaler.h>
+#include <irrlicht-engine/stress_test.h>
+#include <irrlicht-engine/texture_cache.h>
 #include <irrlicht-engine/utils.h>
 #include <irrlicht.h>
+#include <chrono>
+#include <coroutine>
 
 namespace workshop {
 
@@ -55,6 +69,18 @@ public:
    */
   int init(engine* e, object_handle* object);
 
+  /**
+   * Initializes resource with triangles refitted earlier (e.g. restored from a snapshot)
+   *
+   * @param engine     Irrlicht Engine
+   * @param object     Object to connect
+   * @param triangles  Mesh space triangles of the frame
+   * @param frame      Animation frame of the triangles
+   *
+   * @return Initialization status
+   */
+  int init(engine* e, object_handle* object, animated_selector::triangle_storage&& triangles, irr::f32 frame);
+
   /**
    * Releases resource
    */
@@ -62,7 +88,7 @@ public:
 
 private:
   friend object_handle;
-  irr::scene::ITriangleSelector* resource_;  /// Irrlicht resource
+  animated_selector* resource_;  /// Irrlicht resource
 };
 
 /**
@@ -76,6 +102,7 @@ public:
   enum type { type_unknown = -2, type_invalid = -1, type_faerie, type_ninja, type_dwarf, type_yodan, type_num };
 
   object_handle(type t, const std::string* name);
+  ~object_handle();
   bool resource_set(engine* e);
   bool resource_set(irr::scene::IAnimatedMeshSceneNode* resource);
   void position(float x, float y, float z);
@@ -91,6 +118,36 @@ private:
   type type_;                                     /// cached object type
   const std::string* name_;                       /// used temporarily during construction
   irr::scene::IAnimatedMeshSceneNode* resource_;  /// Irrlicht resource
+  engine* engine_;                                /// engine tracking the object in its spatial index
+  int proxy_;                                     /// spatial index proxy
+  animated_selector* selector_;                   /// selector owned by the node, used for picking
+};
+
+/**
+ * @brief Awaitable asynchronous object creation
+ *
+ * Returned by @c engine::spawn_async(). The mesh file of the object and the textures it references are read by
+ * background workers while the frame loop keeps running. The object is then created on the main thread at the end of
+ * @c engine::end_scene() where the awaiting coroutine is resumed, Irrlicht parses the mesh there as it is not
+ * thread-safe. The selector copies no triangles until a ray crosses the object. The result of @c co_await is the
+ * created object owned by the caller or nullptr on failure or when the engine was destroyed first.
+ */
+class spawn_operation : immovable, type_counters<spawn_operation> {
+public:
+  spawn_operation(engine* e, object_handle::type t, std::string name);
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> continuation);
+  object_handle* await_resume() const noexcept { return object_; }
+
+private:
+  friend engine;
+  engine* engine_;                        /// engine creating the object
+  object_handle::type type_;              /// type of the object
+  std::string name_;                      /// name of the object
+  load_request request_;                  /// media files read in the background
+  std::coroutine_handle<> continuation_;  /// awaiting coroutine
+  object_handle* object_;                 /// created object
 };
 
 /**
@@ -108,7 +165,7 @@ public:
 private:
   friend engine;
   irr::scene::ICameraSceneNode* resource_;  /// Irrlicht resource
-  int init(irr::scene::ISceneManager* smgr, irr::scene::IMeshSceneNode* level);
+  int init(irr::scene::ISceneManager* smgr);
 };
 
 /**
@@ -134,8 +191,10 @@ public:
    */
   class event_receiver : public irr::IEventReceiver, type_counters<event_receiver> {
   public:
-    bool quit_;  /// variable used to exit main loop
-    event_receiver() : quit_(false) {}
+    bool quit_;       /// variable used to exit main loop
+    bool jump_;       /// camera jump requested
+    input_log* log_;  /// log recording received events
+    event_receiver() : quit_(false), jump_(false), log_(nullptr) {}
     virtual bool OnEvent(const irr::SEvent& event);
   };
 
@@ -178,6 +237,18 @@ public:
    */
   int init_device(irr::u32 width, irr::u32 height, irr::u32 bpp, bool full_screen, bool stencil, bool vsync);
 
+  /**
+   * Uses textures baked in the native format of the video driver
+   *
+   * The cache file is baked from the media files on first use and whenever it was baked for a different driver.
+   * Should be called after @c init_device() and before @c font(), @c add_laser() and creating objects.
+   *
+   * @param path Cache file
+   *
+   * @return Status, textures are decoded from the media files if the cache cannot be used
+   */
+  bool use_texture_cache(const std::string& path);
+
   /**
    * Adds custom font to the engine
    *
@@ -185,6 +256,24 @@ public:
    */
   bool font();
 
+  /**
+   * Creates object with its selector without blocking the frame loop
+   *
+   * @code
+   *   object_handle* ninja = co_await engine->spawn_async(object_handle::type_ninja, "Ninja");
+   * @endcode
+   *
+   * At most one object is created per frame and the time spent creating it is the spawn phase of the frame statistics.
+   * Coroutines waiting when the engine is destroyed are resumed with nullptr from the destructor and must not use the
+   * engine any more.
+   *
+   * @param t     Object type
+   * @param name  Object name
+   *
+   * @return Awaitable operation
+   */
+  spawn_operation spawn_async(object_handle::type t, std::string name);
+
   /**
    * Configures laser
    *
@@ -192,6 +281,78 @@ public:
    */
   bool add_laser();
 
+  /**
+   * Makes object slide along the level when it is moved instead of passing through it
+   *
+   * The level is created together with the camera so @c create_camera() has to be called first.
+   *
+   * @param object Object to make collision-aware
+   *
+   * @return Status
+   */
+  bool add_collider(object_handle* object);
+
+  /**
+   * Finds objects whose bounding boxes intersect a sphere
+   *
+   * @param center    Sphere center
+   * @param radius    Sphere radius
+   * @param out       Buffer for found objects
+   * @param capacity  Size of the buffer
+   *
+   * @return Number of all found objects, only the first @c capacity of them are stored in the buffer so a result
+   *         greater than @c capacity means the buffer was too small
+   */
+  std::size_t query_sphere(const irr::core::vector3df& center, irr::f32 radius, object_handle** out,
+                           std::size_t capacity) const;
+
+  /**
+   * Finds objects whose bounding boxes intersect a box
+   *
+   * @param box       Axis aligned box
+   * @param out       Buffer for found objects
+   * @param capacity  Size of the buffer
+   *
+   * @return Number of all found objects, only the first @c capacity of them are stored in the buffer so a result
+   *         greater than @c capacity means the buffer was too small
+   */
+  std::size_t query_box(const irr::core::aabbox3df& box, object_handle** out, std::size_t capacity) const;
+
+  /**
+   * Finds objects whose bounding boxes are at least partially inside a frustum
+   *
+   * @param frustum   View frustum (e.g. of the camera)
+   * @param out       Buffer for found objects
+   * @param capacity  Size of the buffer
+   *
+   * @return Number of all found objects, only the first @c capacity of them are stored in the buffer so a result
+   *         greater than @c capacity means the buffer was too small
+   */
+  std::size_t query_frustum(const irr::scene::SViewFrustum& frustum, object_handle** out, std::size_t capacity) const;
+
+  /**
+   * Writes objects, camera and laser state of the scene to a file
+   *
+   * @param path Snapshot file
+   *
+   * @return Status
+   */
+  bool save_snapshot(const std::string& path) const;
+
+  /**
+   * Restores scene written by @c save_snapshot()
+   *
+   * Should be called after @c init_device(), @c font() and @c add_laser() instead of creating the camera and
+   * objects. The camera (with the level) is created if it was present in the snapshot. Triangle selectors of the level
+   * and objects are restored from the snapshot instead of being rebuilt from the meshes.
+   *
+   * @param path     Snapshot file
+   * @param objects  Restored objects owned by the caller
+   *
+   * @return Status
+   */
+  bool load_snapshot(const std::string& path, std::vector<object_handle*>* objects);
+
   /**
    * Adds a light so it is not dark out there
    *
@@ -213,6 +374,127 @@ public:
    */
   void draw_label(const std::string& label);
 
+  /**
+   * Returns statistics of the recent frames
+   *
+   * Statistics of a frame are added to the history by @c end_scene().
+   *
+   * @return Frame statistics history
+   */
+  const frame_history& stats() const { return stats_history_; }
+
+  /**
+   * Returns memory used by engine subsystems
+   *
+   * Memory of engine-owned containers and triangle selectors is tracked by their allocators for the whole process.
+   * Memory of meshes, textures and fonts of this engine is estimated from their sizes when the report is made; those
+   * subsystems have no high-water marks, their peak is reported equal to the current estimate.
+   *
+   * @return Current usage and high-water marks in bytes
+   */
+  memory_counters::data memory_report() const;
+
+  /**
+   * Runs the stress scenario
+   *
+   * For every object type increasing numbers of objects with selectors are created around the camera and the camera
+   * makes a full turn at each step. Frame time, picking time and memory are measured at every step. Objects of a type
+   * are destroyed before the next type is tested. Should be called after @c create_camera() and @c add_laser(),
+   * typically on a device created with @c device_null.
+   *
+   * @param config  Object counts and sweep length
+   * @param report  Measured steps
+   *
+   * @return Status
+   */
+  bool stress_test(const stress_config& config, stress_report* report);
+
+  /**
+   * Enables drawing of the frame statistics on the screen
+   *
+   * @param enable Overlay state
+   */
+  void stats_overlay(bool enable) { stats_overlay_ = enable; }
+
+  /**
+   * Enables dynamic resolution scaling of the 3D scene
+   *
+   * The scene is rendered at a resolution that adapts every frame to hold the frame time budget and is upscaled to
+   * the window. HUD labels are drawn at the native resolution.
+   *
+   * @param budget_ms  Frame time budget measured from @c begin_scene() to the end of @c end_scene()
+   * @param min_scale  Lowest allowed scale of each axis
+   *
+   * @return Status
+   */
+  bool enable_dynamic_resolution(float budget_ms, float min_scale = 0.5f);
+
+  /**
+   * Disables dynamic resolution scaling
+   */
+  void disable_dynamic_resolution();
+
+  /**
+   * Starts recording input events and camera transforms of every frame
+   *
+   * Scene time advances by a fixed step per frame while recording so that the log can be replayed deterministically.
+   *
+   * @param path     Log file
+   * @param step_ms  Scene time step per frame
+   *
+   * @return Status
+   */
+  bool start_recording(const std::string& path, irr::u32 step_ms = 16);
+
+  /**
+   * Starts replaying log written by @c start_recording()
+   *
+   * Recorded events are posted to the device, the camera follows recorded transforms and scene time advances by the
+   * recorded step per frame. The engine quits when the log ends.
+   *
+   * @param path Log file
+   *
+   * @return Status
+   */
+  bool start_replay(const std::string& path);
+
+  /**
+   * Stops recording or replay and returns to the real time
+   *
+   * Recording is also stopped by the engine as soon as the log cannot be written, see @c input_log_failed().
+   */
+  void stop_input_log();
+
+  /**
+   * Checks whether the last recording stopped because the log could not be written
+   *
+   * @return @c true if the log is incomplete
+   */
+  bool input_log_failed() const { return input_log_.failed(); }
+
+  /**
+   * Starts writing rendered frames to a file or a named pipe
+   *
+   * While capture is active frames are rendered into a render target of the current window size, captured by
+   * @c end_scene() and written on a background thread. Frames are dropped when the writer falls behind by more than
+   * @p buffers frames.
+   *
+   * @param path     Output path
+   * @param f        Stream format
+   * @param fps      Frame rate stored in the stream header
+   * @param buffers  Number of reusable frame buffers
+   *
+   * @return Status
+   */
+  bool start_capture(const std::string& path, frame_capture::format f, irr::u32 fps, std::size_t buffers = 4);
+
+  /**
+   * Flushes queued frames and stops capture
+   */
+  void stop_capture();
+
+  frame_capture::statistics capture_stats() const { return capture_.stats(); }
+
   /**
    * Creates internal event receiver
    *
@@ -249,6 +531,7 @@ public:
 private:
   friend object_handle;
   friend selector;
+  friend spawn_operation;
 
   const std::string irrlicht_media_path_;  /// path to media directory of the Irrlicht library
   device_type device_type_;                /// device type
@@ -258,14 +541,54 @@ private:
   irr_runtime runtime_;                     /// Irrlicht runtime
   irr::gui::IGUIFont* font_;                /// Irrlicht font resource to use
   irr::scene::IBillboardSceneNode* laser_;  /// Irrlicht resource used for laser
-
-  camera* camera_;                  /// engine camera
-  object_handle* selected_object_;  /// selected object found by collision detection algorithm
+  texture_cache textures_;                  /// baked textures
+
+  camera* camera_;                            /// engine camera
+  object_handle* selected_object_;            /// selected object found by collision detection algorithm
+  render_queue render_queue_;                 /// material-sorted queue drawing level, characters, laser and HUD
+  collision_world collision_;                 /// collision resolver for the camera and moving characters
+  aabb_tree objects_;                         /// spatial index of all objects
+  tracked_vector<object_handle*> colliders_;  /// objects moved by the collision resolver
+  irr::scene::IMeshSceneNode* level_;         /// level node
+
+  frame_stats stats_;                                /// statistics of the current frame
+  irr::u32 selectors_;                               /// triangle selectors of the level and tracked objects
+  irr::u32 selector_triangles_;                      /// triangles held by the counted selectors
+  irr::u32 texture_count_;                           /// driver textures summed in texture_memory_
+  std::size_t texture_memory_;                       /// estimated memory used by the driver textures in bytes
+  irr::core::dimension2d<irr::u32> texture_screen_;  /// window size when the textures were summed
+  frame_history stats_history_;                      /// statistics of the recent frames
+  bool stats_overlay_;                               /// draws statistics on the screen
+  std::chrono::steady_clock::time_point frame_end_;  /// end of the previous frame
+  frame_capture capture_;                            /// background frame writer
+  resolution_scaler scaler_;                         /// dynamic resolution controller
+  async_loader loader_;                              /// background reader of media files for spawned objects
+  tracked_vector<spawn_operation*> spawning_;        /// operations submitted to the loader and not completed yet
+  input_log input_log_;                              /// recorded or replayed input
+  irr::u32 log_time_;                                /// scene time while recording or replaying
+  bool log_restart_;                                 /// animations have to be rewound for the first logged frame
+  std::vector<irr::SEvent> replay_events_;           /// events of the replayed frame
+  irr::core::vector3df replay_position_;             /// camera position of the replayed frame
+  irr::core::vector3df replay_target_;               /// camera target of the replayed frame
 
   irr::video::E_DRIVER_TYPE convert(device_type type);
-  int add_level(irr::scene::IMeshSceneNode** level);
+  int create_camera(camera** c, baked_selector::data* level);
+  int add_level(irr::scene::IMeshSceneNode** level, baked_selector::data* baked);
   irr_runtime* runtime() { return &runtime_; }
   int process_collisions();
+  void track(object_handle* object);
+  void untrack(object_handle* object);
+  void refit(object_handle* object);
+  void add_selector(const irr::scene::ITriangleSelector* selector);
+  void remove_selector(const irr::scene::ITriangleSelector* selector);
+  void sample_stats();
+  bool spawn(spawn_operation* operation);
+  void finish_spawn(spawn_operation* operation);
+  void destroy_object(object_handle* object);
+  void complete_spawns();
+  void abandon_spawns();
+  void start_input_log();
+  void draw_stats();
 };
 
 }  // namespace workshop
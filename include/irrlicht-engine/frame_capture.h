@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace workshop {
+
+/**
+ * @brief Asynchronous frame capture
+ *
+ * While capture is active frames are rendered into a render target texture of the stream size. At the end of the
+ * frame the target is converted to RGB once, straight into one of a fixed pool of reusable buffers, and then shown in
+ * the window. Queued buffers are written to a file or a named pipe on a background thread. When the writer cannot
+ * keep up and all buffers are queued the frame is dropped without reading the target.
+ */
+class frame_capture : immovable, type_counters<frame_capture> {
+public:
+  enum format {
+    format_raw,  /// headerless RGB24 stream
+    format_ppm,  /// concatenated binary PPM images
+    format_y4m   /// YUV4MPEG2 stream with 4:2:0 chroma subsampling
+  };
+
+  struct statistics {
+    irr::u32 captured;  /// frames copied from the back buffer
+    irr::u32 dropped;   /// frames skipped because no buffer was free
+    irr::u32 written;   /// frames written by the background thread
+    irr::u32 failed;    /// frames that could not be written
+  };
+
+  frame_capture();
+  ~frame_capture();
+
+  /**
+   * Creates render target, opens output and starts the writer thread
+   *
+   * @param driver   Irrlicht driver
+   * @param path     Output file or named pipe
+   * @param f        Stream format
+   * @param width    Frame width, the window shows frames unscaled
+   * @param height   Frame height
+   * @param fps      Frame rate stored in the stream header
+   * @param buffers  Number of frame buffers (bounds the queue)
+   *
+   * @return Status
+   */
+  [[nodiscard]] bool start(irr::video::IVideoDriver* driver, const std::string& path, format f, irr::u32 width,
+                           irr::u32 height, irr::u32 fps, std::size_t buffers);
+
+  /**
+   * Writes all queued frames, stops the writer thread, closes output and releases render target
+   */
+  void stop();
+
+  bool active() const { return file_ != nullptr; }
+  irr::video::ITexture* target() const { return target_; }
+
+  /**
+   * Redirects rendering to the render target
+   *
+   * Should be called after @c IVideoDriver::beginScene().
+   *
+   * @param driver Irrlicht driver
+   */
+  void begin(irr::video::IVideoDriver* driver);
+
+  /**
+   * Queues the rendered frame and shows it in the window
+   *
+   * Should be called before @c IVideoDriver::endScene().
+   *
+   * @param driver Irrlicht driver
+   */
+  void capture(irr::video::IVideoDriver* driver);
+
+  statistics stats() const;
+
+private:
+  struct frame {
+    tracked_vector<irr::u8, memory_counters::capture_buffers> pixels;  /// RGB24 pixels
+  };
+
+  irr::video::IVideoDriver* driver_;                               /// driver owning the render target
+  irr::video::ITexture* target_;                                   /// render target of the stream size
+  std::FILE* file_;                                                /// output stream
+  format format_;                                                  /// stream format
+  irr::u32 width_;                                                 /// frame width
+  irr::u32 height_;                                                /// frame height
+  std::vector<frame> frames_;                                      /// frame buffer pool
+  std::vector<frame*> free_;                                       /// frame buffers ready to be filled
+  std::deque<frame*> queue_;                                       /// frame buffers waiting to be written
+  tracked_vector<irr::u8, memory_counters::capture_buffers> yuv_;  /// conversion buffer of the writer thread
+  statistics stats_;                                               /// frame counters
+  bool stopping_;                                                  /// writer thread should exit when the queue is empty
+  mutable std::mutex mutex_;                                       /// guards free_, queue_, stats_ and stopping_
+  std::condition_variable ready_;                                  /// signals queued frames and stop requests
+  std::thread writer_;                                             /// background writer
+
+  void run();
+  bool write(const frame& f);
+};
+
+}  // namespace workshop
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+#include <array>
+#include <cstddef>
+
+namespace workshop {
+
+/**
+ * @brief Statistics of a single frame
+ *
+ * Counters are sampled from the driver, the render queue and the scene after @c engine::end_scene(). Times are
+ * measured in milliseconds. The spawn phase is the time spent creating objects of @c engine::spawn_async() at the end
+ * of the frame, the hitch those objects add to the frame loop.
+ */
+struct frame_stats {
+  enum phase {
+    phase_scene,
+    phase_collision,
+    phase_picking,
+    phase_render,
+    phase_gui,
+    phase_present,
+    phase_spawn,
+    phase_num
+  };
+
+  irr::u32 frame;                         /// frame number
+  irr::s32 fps;                           /// frames per second reported by the driver
+  float frame_ms;                         /// time since the end of the previous frame
+  float resolution_scale;                 /// scale of the 3D scene resolution
+  std::array<float, phase_num> phase_ms;  /// time spent in each phase of the frame
+  irr::u32 primitives;                    /// primitives drawn by the driver
+  irr::u32 nodes_rendered;                /// nodes drawn by the render queue
+  irr::u32 nodes_culled;                  /// nodes culled by the render queue
+  irr::u32 draws;                         /// draws submitted by the render queue
+  irr::u32 material_changes;              /// draws changing the material of the previous draw
+  irr::u32 textures;                      /// textures loaded by the driver
+  std::size_t texture_memory;             /// estimated memory used by the textures in bytes
+  irr::u32 selectors;                     /// triangle selectors of the level and objects
+  irr::u32 selector_triangles;            /// triangles held by the selectors
+  irr::u32 picking_rays;                  /// rays cast by the laser
+  irr::u32 picking_tests;                 /// ray tests against selectors passing the box checks
+  irr::u32 spawns;                        /// objects created for spawn_async() at the end of the frame
+
+  static const char* name(phase p);
+};
+
+/**
+ * @brief Rolling history of frame statistics
+ *
+ * Keeps statistics of the last @c capacity frames in a ring buffer so that no memory is allocated per frame.
+ */
+class frame_history : type_counters<frame_history> {
+public:
+  static constexpr std::size_t capacity = 128;
+
+  frame_history();
+
+  /**
+   * Appends statistics of a frame, the oldest frame is dropped when the history is full
+   *
+   * @param stats Frame statistics
+   */
+  void push(const frame_stats& stats);
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * Returns statistics of a frame
+   *
+   * @param age Index of the frame counted from the newest one (0)
+   *
+   * @return Frame statistics
+   */
+  const frame_stats& operator[](std::size_t age) const;
+  const frame_stats& last() const { return (*this)[0]; }
+
+  float average_frame_ms() const;
+  float max_frame_ms() const;
+
+private:
+  std::array<frame_stats, capacity> frames_;  /// ring buffer
+  std::size_t next_;                          /// slot of the next frame
+  std::size_t size_;                          /// number of stored frames
+};
+
+}  // namespace workshop
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace workshop {
+
+/**
+ * @brief Binary log of input events and camera transforms
+ *
+ * The log starts with a header (magic, version and time step) followed by records. Key and mouse event records
+ * store the events received before a frame and a frame record stores the camera transform used to render that
+ * frame. Values are stored in the native byte order.
+ */
+class input_log : immovable, type_counters<input_log> {
+public:
+  enum mode { mode_off, mode_record, mode_replay };
+
+  static constexpr irr::u32 version = 1;
+
+  input_log();
+  ~input_log();
+
+  /**
+   * Creates log for recording
+   *
+   * @param path     Output file
+   * @param step_ms  Scene time step per frame
+   *
+   * @return Status
+   */
+  [[nodiscard]] bool record(const std::string& path, irr::u32 step_ms);
+
+  /**
+   * Opens log for replay
+   *
+   * @param path Input file
+   *
+   * @return Status
+   */
+  [[nodiscard]] bool replay(const std::string& path);
+
+  /**
+   * Closes log
+   *
+   * @return @c false if buffered records of a recording could not be written
+   */
+  bool close();
+
+  mode state() const { return mode_; }
+  irr::u32 step_ms() const { return step_ms_; }
+
+  /**
+   * Checks whether the last recording failed
+   *
+   * Nothing is appended to the log after a failed write, so it ends with the last complete record. The state is
+   * cleared by @c record().
+   *
+   * @return @c true if any record could not be written
+   */
+  bool failed() const { return failed_; }
+
+  /**
+   * Appends key or mouse event, other events are ignored
+   *
+   * @param event Irrlicht event
+   *
+   * @return Status, @c false also after any previous write failed
+   */
+  [[nodiscard]] bool write_event(const irr::SEvent& event);
+
+  /**
+   * Ends frame by appending camera transform
+   *
+   * @param position  Camera position
+   * @param target    Camera target
+   *
+   * @return Status, @c false also after any previous write failed
+   */
+  [[nodiscard]] bool write_frame(const irr::core::vector3df& position, const irr::core::vector3df& target);
+
+  /**
+   * Reads records of the next frame
+   *
+   * @param events    Events received before the frame
+   * @param position  Camera position
+   * @param target    Camera target
+   *
+   * @return @c false at the end of the log or if it is corrupted
+   */
+  [[nodiscard]] bool read_frame(std::vector<irr::SEvent>* events, irr::core::vector3df* position,
+                                irr::core::vector3df* target);
+
+private:
+  std::FILE* file_;   /// log file
+  mode mode_;         /// recording or replaying
+  irr::u32 step_ms_;  /// scene time step per frame
+  bool failed_;       /// a record could not be written, recording stopped
+};
+
+}  // namespace workshop
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+#include <string>
+#include <vector>
+
+namespace workshop {
+
+/**
+ * @brief Material-sorted render queue
+ *
+ * @c render_queue takes over drawing of the level, characters, laser and HUD labels from the Irrlicht scene manager.
+ * Registered nodes are moved under a scene node owned by the queue. The scene manager still animates them, but
+ * instead of registering them for rendering it draws the queue in its solid and transparent passes. In the solid
+ * pass the queue collects the draws of all visible nodes that survived culling, sorts them by render pass, material
+ * type, texture and lighting so that nodes sharing a material are drawn one after another. Each node draws itself,
+ * animated characters included, because their meshes are shared and animated in place for the drawn node only.
+ * HUD labels are deferred until the end of the frame so that all font draws are batched together.
+ */
+class render_queue : type_counters<render_queue> {
+public:
+  enum render_pass { pass_solid, pass_transparent };
+
+  struct statistics {
+    irr::u32 nodes;             /// registered nodes drawn in the last frame
+    irr::u32 items;             /// draws submitted in the last frame
+    irr::u32 culled;            /// registered nodes culled in the last frame
+    irr::u32 material_changes;  /// draws in the last frame whose material differs from the previous draw
+    irr::u32 material_elided;   /// draws in the last frame sharing the material of the previous draw
+  };
+
+  render_queue();
+
+  /**
+   * Registers scene node to be rendered by the queue
+   *
+   * The node becomes a child of the queue scene node. If that node cannot be created the scene manager keeps
+   * drawing the registered node.
+   *
+   * @param node Irrlicht scene node without a parent
+   */
+  void add(irr::scene::ISceneNode* node);
+
+  /**
+   * Unregisters scene node and gives it back to the scene manager
+   *
+   * @param node Irrlicht scene node
+   */
+  void remove(irr::scene::ISceneNode* node);
+
+  /**
+   * Queues HUD label to be drawn at the end of the frame
+   *
+   * @param text      Text to draw
+   * @param position  Screen rectangle of the label
+   * @param color     Text color
+   * @param hcenter   Centers text horizontally
+   * @param vcenter   Centers text vertically
+   */
+  void add_label(std::wstring text, const irr::core::rect<irr::s32>& position, irr::video::SColor color, bool hcenter,
+                 bool vcenter);
+
+  /**
+   * Draws all queued HUD labels
+   *
+   * @param font Font to draw with
+   */
+  void submit_labels(irr::gui::IGUIFont* font);
+
+  const statistics& stats() const { return stats_; }
+
+private:
+  struct item {
+    render_pass pass;                     /// render pass
+    irr::video::E_MATERIAL_TYPE type;     /// material type
+    const irr::video::ITexture* texture;  /// first texture layer
+    bool lighting;                        /// lighting flag toggled by highlighting
+    irr::f32 distance;                    /// squared distance to camera used to sort transparent draws
+    irr::scene::ISceneNode* node;         /// node drawing itself
+  };
+
+  struct label {
+    std::wstring text;                   /// text to draw
+    irr::core::rect<irr::s32> position;  /// screen rectangle
+    irr::video::SColor color;            /// text color
+    bool hcenter;                        /// horizontal centering
+    bool vcenter;                        /// vertical centering
+  };
+
+  class scene_node;
+
+  scene_node* node_;                                 /// parent of registered nodes, owned by the scene manager
+  tracked_vector<irr::scene::ISceneNode*> nodes_;    /// registered nodes
+  tracked_vector<irr::scene::ISceneNode*> visible_;  /// registered nodes visible in the current frame
+  tracked_vector<item> items_;                       /// draws of the current frame
+  tracked_vector<label> labels_;                     /// HUD labels of the current frame
+  statistics stats_;                                 /// statistics of the last frame
+
+  void collect(irr::scene::ISceneNode* node, const irr::core::vector3df& camera_position);
+  void prepare(irr::scene::ISceneManager* smgr);
+  void submit(irr::video::IVideoDriver* driver, render_pass pass);
+};
+
+}  // namespace workshop
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+
+namespace workshop {
+
+/**
+ * @brief Dynamic resolution controller
+ *
+ * Renders the 3D scene into a render target texture using a viewport that covers only a fraction of it and
+ * upscales the result to the window. After every frame the fraction is adjusted so that the measured frame time
+ * approaches the configured budget. Rendering time is assumed to be proportional to the number of pixels so the
+ * scale of each axis follows the square root of the budget to frame time ratio.
+ *
+ * The @c EDT_SOFTWARE driver cannot draw scaled images, so with it the viewport is upscaled on the CPU into a texture
+ * of the window size which is then drawn unscaled. Render targets are recreated when the window size changes.
+ */
+class resolution_scaler : type_counters<resolution_scaler> {
+public:
+  resolution_scaler();
+
+  /**
+   * Creates render target and enables scaling
+   *
+   * @param driver     Irrlicht driver
+   * @param budget_ms  Frame time budget
+   * @param min_scale  Lowest allowed scale of each axis (0, 1]
+   *
+   * @return Status
+   */
+  [[nodiscard]] bool enable(irr::video::IVideoDriver* driver, float budget_ms, float min_scale);
+
+  /**
+   * Releases render target and disables scaling
+   *
+   * @param driver Irrlicht driver
+   */
+  void disable(irr::video::IVideoDriver* driver);
+
+  bool enabled() const { return target_ != nullptr; }
+  float scale() const { return scale_; }
+
+  /**
+   * Redirects rendering to the scaled viewport of the render target
+   *
+   * Scaling is disabled if render targets cannot be recreated for a new window size.
+   *
+   * @param driver Irrlicht driver
+   */
+  void begin(irr::video::IVideoDriver* driver);
+
+  /**
+   * Restores the output render target and upscales rendered image to it
+   *
+   * @param driver  Irrlicht driver
+   * @param output  Render target receiving the image or @c nullptr for the frame buffer
+   */
+  void resolve(irr::video::IVideoDriver* driver, irr::video::ITexture* output);
+
+  /**
+   * Adjusts scale for the next frame
+   *
+   * @param frame_ms Time spent between the beginning and the end of the last frame
+   */
+  void update(float frame_ms);
+
+private:
+  irr::video::ITexture* target_;           /// render target of the window size
+  irr::video::ITexture* output_;           /// texture the CPU upscales into, only with the software driver
+  irr::core::dimension2d<irr::u32> size_;  /// window size
+  tracked_vector<irr::u32> columns_;       /// byte offsets of the source pixels of output columns
+  bool cpu_;                               /// upscales on the CPU
+  float budget_ms_;                        /// frame time budget
+  float min_scale_;                        /// lowest allowed scale
+  float scale_;                            /// current scale of each axis
+  float average_ms_;                       /// smoothed frame time
+
+  irr::core::rect<irr::s32> viewport() const;
+  bool create(irr::video::IVideoDriver* driver, const irr::core::dimension2d<irr::u32>& size);
+  void release(irr::video::IVideoDriver* driver);
+  bool upscale();
+};
+
+}  // namespace workshop
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/animated_selector.h>
+#include <irrlicht-engine/baked_selector.h>
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+#include <string>
+#include <vector>
+
+namespace workshop {
+
+/**
+ * @brief Set-up state of a scene
+ *
+ * Stored in a versioned binary file made of fixed-size records so that it can be mapped into memory and parsed
+ * without any per-field I/O. The layout is:
+ * - header: magic, version, record counts and offsets, camera and laser state
+ * - object records: type, name location, transform, animation frame, flags and selector triangles location
+ * - clusters: baked clusters of the level selector
+ * - triangles: mesh space triangles of the level selector followed by triangles of the object selectors
+ * - names: characters of all object names
+ *
+ * All values are 4 bytes long and stored in the native byte order.
+ */
+struct scene_snapshot {
+  static constexpr irr::u32 version = 2;
+
+  struct object {
+    irr::s32 type;                                  /// object_handle::type
+    std::string name;                               /// object name
+    irr::core::vector3df position;                  /// relative position
+    irr::core::vector3df rotation;                  /// relative rotation in degrees
+    irr::f32 frame;                                 /// current animation frame
+    bool selector;                                  /// object has a triangle selector
+    bool collider;                                  /// object collides with the level
+    irr::f32 selector_frame;                        /// animation frame the selector triangles are refitted to
+    animated_selector::triangle_storage triangles;  /// mesh space triangles of the selector
+  };
+
+  bool camera;                           /// camera and level were created
+  irr::core::vector3df camera_position;  /// camera position
+  irr::core::vector3df camera_target;    /// camera target
+  bool laser;                            /// laser was created
+  bool laser_visible;                    /// laser points at something
+  irr::core::vector3df laser_position;   /// laser position
+  baked_selector::data level;            /// triangle selector of the level
+  std::vector<object> objects;           /// objects of the scene
+
+  /**
+   * Writes snapshot to a file
+   *
+   * @param path Output file
+   *
+   * @return Status
+   */
+  [[nodiscard]] bool save(const std::string& path) const;
+
+  /**
+   * Reads snapshot from a file
+   *
+   * The file is mapped into memory and triangles are copied out of it in bulk.
+   *
+   * @param path Input file
+   *
+   * @return Status, @c false also for files of a different version
+   */
+  [[nodiscard]] bool load(const std::string& path);
+};
+
+}  // namespace workshop
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace workshop {
+
+/**
+ * @brief Settings of the stress scenario run by @c engine::stress_test()
+ */
+struct stress_config {
+  std::vector<std::size_t> counts = {10, 100, 1000, 10000};  /// objects of a single type at consecutive steps
+  unsigned sweep_frames = 120;                               /// frames of a full camera turn measured at each step
+};
+
+/**
+ * @brief Results of the stress scenario
+ *
+ * Every step holds means over a full camera turn with a given number of objects of a single type.
+ */
+struct stress_report {
+  struct step {
+    const char* type;     /// object type name
+    std::size_t objects;  /// objects of the type in the scene
+    float frame_ms;       /// mean frame time
+    float max_frame_ms;   /// longest frame
+    float picking_ms;     /// mean picking time
+    std::size_t memory;   /// memory used by all engine subsystems
+  };
+
+  std::vector<step> steps;  /// steps in the order of execution
+
+  /**
+   * Prints steps with their growth relative to the previous step of the same type
+   *
+   * Growth is the ratio of frame (or picking) time increase to the object count increase. Values below 1 mean that
+   * fixed costs still dominate, values close to 1 mean linear scaling and higher values show where the engine stops
+   * scaling linearly.
+   */
+  void print() const;
+};
+
+}  // namespace workshop
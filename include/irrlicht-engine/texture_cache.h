@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <irrlicht.h>
+#include <string>
+#include <vector>
+
+namespace workshop {
+
+/**
+ * @brief Textures baked in the native pixel format of a video driver
+ *
+ * Textures found in the cache are created without decoding their image files and converting pixels. Precomputed
+ * mipmap levels are handed over to the driver instead of being generated. The cache file is mapped into memory and
+ * pixels are used in place, the mapping keeps their 16 byte alignment. The layout is:
+ * - header: magic, version, driver type, record count and offsets
+ * - texture records: name location, color format, size, number of mipmap levels and pixels location
+ * - names: characters of all texture names
+ * - pixels: all mipmap levels of a texture one after another, each texture aligned to 16 bytes
+ *
+ * All values are 4 bytes long and stored in the native byte order. Image files loaded by other means (e.g. by the
+ * font loader) are also taken from the cache.
+ */
+class texture_cache : immovable, type_counters<texture_cache> {
+public:
+  static constexpr irr::u32 version = 1;
+
+  texture_cache() = default;
+  ~texture_cache();
+
+  /**
+   * Reads cache file and makes its textures available to the driver
+   *
+   * @param path    Cache file
+   * @param driver  Video driver the textures were baked for
+   * @param fs      File system used to resolve texture names
+   *
+   * @return Status, @c false also for files of a different version or baked for a different driver
+   */
+  [[nodiscard]] bool open(const std::string& path, irr::video::IVideoDriver* driver, irr::io::IFileSystem* fs);
+
+  /**
+   * Checks if a texture is in the opened cache
+   *
+   * @param name Texture file name
+   */
+  [[nodiscard]] bool contains(const std::string& name) const;
+
+  /**
+   * Returns a texture from the opened cache
+   *
+   * Textures already created by the driver are returned without touching the cache.
+   *
+   * @param name Texture file name
+   *
+   * @return Texture or @c nullptr if it is not in the cache
+   */
+  irr::video::ITexture* get_texture(const std::string& name);
+
+  /**
+   * Copies pixels of all mipmap levels of a texture to be written to a new cache file
+   *
+   * @param name     Texture file name
+   * @param texture  Texture created by the driver from the file
+   *
+   * @return Status, @c false for compressed formats or textures that cannot be locked
+   */
+  [[nodiscard]] bool add(const std::string& name, irr::video::ITexture* texture);
+
+  /**
+   * Copies pixels of an image to be written to a new cache file
+   *
+   * Used for files which are not loaded as textures by the driver (e.g. font bitmaps).
+   *
+   * @param name   Image file name
+   * @param image  Image decoded from the file
+   *
+   * @return Status
+   */
+  [[nodiscard]] bool add(const std::string& name, irr::video::IImage* image);
+
+  /**
+   * Writes added textures to a file
+   *
+   * @param path    Output file
+   * @param driver  Video driver the textures were created by
+   *
+   * @return Status
+   */
+  [[nodiscard]] bool write(const std::string& path, irr::video::IVideoDriver* driver) const;
+
+private:
+  struct baked_texture {
+    std::string name;                       /// file name as passed to add()
+    irr::video::ECOLOR_FORMAT format;       /// native pixel format
+    irr::core::dimension2d<irr::u32> size;  /// size of the first level
+    irr::u32 levels;                        /// number of mipmap levels
+    std::vector<char> pixels;               /// tightly packed pixels of all levels
+  };
+
+  class storage;
+
+  storage* storage_ = nullptr;        /// opened cache shared with the driver
+  std::vector<baked_texture> baked_;  /// textures to write
+};
+
+}  // namespace workshop
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <irrlicht-engine/utils.h>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace workshop {
+
+/**
+ * Records timed spans and writes them in Chrome trace event format
+ *
+ * The written file can be opened in chrome://tracing or https://ui.perfetto.dev. Recording is disabled by default
+ * and a disabled log costs a single check per span.
+ *
+ * @note Singleton design pattern
+ */
+class trace_log : immovable {
+public:
+  using clock = std::chrono::steady_clock;
+
+  [[nodiscard]] static trace_log& instance();
+
+  /**
+   * Starts recording, spans recorded earlier are discarded
+   */
+  void start();
+
+  /**
+   * Stops recording
+   */
+  void stop();
+
+  [[nodiscard]] bool enabled() const { return enabled_; }
+
+  /**
+   * Records a span
+   *
+   * @param name    Span name
+   * @param detail  Additional information shown with the span (e.g. file name), may be empty
+   * @param begin   Start time
+   * @param end     End time
+   */
+  void add(const char* name, const std::string& detail, clock::time_point begin, clock::time_point end);
+
+  /**
+   * Writes recorded spans to a JSON file
+   *
+   * @param path Output file path
+   *
+   * @return Status
+   */
+  [[nodiscard]] bool write(const std::string& path) const;
+
+private:
+  struct event {
+    const char* name;         /// span name
+    std::string detail;       /// span argument
+    clock::time_point begin;  /// start time
+    clock::time_point end;    /// end time
+    std::thread::id thread;   /// recording thread
+  };
+
+  std::atomic<bool> enabled_ = false;  /// recording flag
+  clock::time_point origin_;           /// start of recording
+  std::vector<event> events_;          /// recorded spans
+  mutable std::mutex mutex_;           /// guards events_
+  trace_log() = default;
+};
+
+/**
+ * Records the lifetime of a scope as a span in the trace log
+ *
+ * Span details are copied or computed only when recording is enabled, so details that need formatting should be
+ * passed as a callable returning @c std::string.
+ *
+ * @note RAII design pattern
+ */
+class trace_scope : immovable {
+public:
+  explicit trace_scope(const char* name);
+  trace_scope(const char* name, const char* detail);
+  trace_scope(const char* name, const std::string& detail);
+
+  template<std::invocable Detail>
+  trace_scope(const char* name, Detail detail) : name_(name), enabled_(trace_log::instance().enabled())
+  {
+    if (!enabled_) return;
+    detail_ = detail();
+    begin_ = trace_log::clock::now();
+  }
+
+  ~trace_scope();
+
+private:
+  const char* name_;                    /// span name
+  std::string detail_;                  /// span argument
+  trace_log::clock::time_point begin_;  /// start time
+  bool enabled_;                        /// recording was enabled on scope entry
+};
+
+}  // namespace workshop
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <irrlicht.h>
+
+namespace workshop {
+
+/**
+ * Returns vertex index stored at a position of the index buffer of a mesh buffer
+ *
+ * @param buffer Mesh buffer with 16 or 32 bit indices
+ * @param i      Position in the index buffer
+ *
+ * @return Vertex index
+ */
+inline irr::u32 vertex_index(const irr::scene::IMeshBuffer* buffer, irr::u32 i)
+{
+  if (buffer->getIndexType() == irr::video::EIT_32BIT)
+    return reinterpret_cast<const irr::u32*>(buffer->getIndices())[i];
+  return buffer->getIndices()[i];
+}
+
+/**
+ * Transforms all points of a triangle
+ *
+ * @param m    Transformation
+ * @param in   Source triangle
+ * @param out  Transformed triangle
+ */
+inline void transform_triangle(const irr::core::matrix4& m, const irr::core::triangle3df& in,
+                               irr::core::triangle3df* out)
+{
+  m.transformVect(out->pointA, in.pointA);
+  m.transformVect(out->pointB, in.pointB);
+  m.transformVect(out->pointC, in.pointC);
+}
+
+}  // namespace workshop
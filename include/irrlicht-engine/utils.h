@@ -23,7 +23,10 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <cstddef>
 #include <deque>
+#include <memory>
 #include <string>
 #include <typeinfo>
 #include <vector>
@@ -72,6 +75,87 @@ private:
   counters() = default;
 };
 
+/**
+ * Stores the amount of memory used by engine subsystems and its high-water marks.
+ *
+ * Containers owned by the engine report their allocations through @c tracked_allocator, so only their subsystems
+ * have real high-water marks here. Memory of Irrlicht resources (mesh cache, textures, fonts) cannot be tracked and
+ * stays zero in this registry, @c engine::memory_report() estimates it for a single engine instead.
+ *
+ * @note Singleton design pattern
+ */
+class memory_counters : immovable {
+public:
+  enum {
+    mesh_cache,
+    textures,
+    level_selector,
+    object_selectors,
+    fonts,
+    engine_data,
+    capture_buffers,
+
+    last = capture_buffers
+  };
+  static constexpr int num = last + 1;
+
+  struct usage {
+    std::size_t current;  /// bytes in use
+    std::size_t peak;     /// high-water mark
+  };
+  using data = std::array<usage, num>;
+
+  [[nodiscard]] static memory_counters& instance();
+
+  void allocated(int subsystem, std::size_t bytes);
+  void deallocated(int subsystem, std::size_t bytes);
+  [[nodiscard]] data get() const;
+  void print() const;
+
+private:
+  std::array<std::atomic<std::size_t>, num> current_{};
+  std::array<std::atomic<std::size_t>, num> peak_{};
+  memory_counters() = default;
+  void update_peak(int subsystem, std::size_t bytes);
+};
+
+/**
+ * Allocator reporting its allocations to @c memory_counters.
+ */
+template<typename T, int Subsystem = memory_counters::engine_data>
+class tracked_allocator {
+public:
+  using value_type = T;
+
+  template<typename U>
+  struct rebind {
+    using other = tracked_allocator<U, Subsystem>;
+  };
+
+  tracked_allocator() = default;
+  template<typename U>
+  tracked_allocator(const tracked_allocator<U, Subsystem>&) {}
+
+  [[nodiscard]] T* allocate(std::size_t n)
+  {
+    T* ptr = std::allocator<T>().allocate(n);
+    memory_counters::instance().allocated(Subsystem, n * sizeof(T));
+    return ptr;
+  }
+
+  void deallocate(T* ptr, std::size_t n)
+  {
+    memory_counters::instance().deallocated(Subsystem, n * sizeof(T));
+    std::allocator<T>().deallocate(ptr, n);
+  }
+
+  template<typename U>
+  bool operator==(const tracked_allocator<U, Subsystem>&) const { return true; }
+};
+
+template<typename T, int Subsystem = memory_counters::engine_data>
+using tracked_vector = std::vector<T, tracked_allocator<T, Subsystem> >;
+
 /**
  * Counts special class operations done on specific types.
  *
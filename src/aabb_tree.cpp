@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The tree follows the dynamic AABB tree of Box2D by Erin Catto (http://box2d.org)
+ */
+
+#include <irrlicht-engine/aabb_tree.h>
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+irr::core::aabbox3df combine(const irr::core::aabbox3df& a, const irr::core::aabbox3df& b)
+{
+  return irr::core::aabbox3df(
+    irr::core::vector3df(std::min(a.MinEdge.X, b.MinEdge.X), std::min(a.MinEdge.Y, b.MinEdge.Y),
+                         std::min(a.MinEdge.Z, b.MinEdge.Z)),
+    irr::core::vector3df(std::max(a.MaxEdge.X, b.MaxEdge.X), std::max(a.MaxEdge.Y, b.MaxEdge.Y),
+                         std::max(a.MaxEdge.Z, b.MaxEdge.Z)));
+}
+
+irr::f32 area(const irr::core::aabbox3df& box)
+{
+  const irr::core::vector3df e = box.MaxEdge - box.MinEdge;
+  return 2.f * (e.X * e.Y + e.Y * e.Z + e.Z * e.X);
+}
+
+bool contains(const irr::core::aabbox3df& outer, const irr::core::aabbox3df& inner)
+{
+  return outer.MinEdge.X <= inner.MinEdge.X && outer.MinEdge.Y <= inner.MinEdge.Y &&
+         outer.MinEdge.Z <= inner.MinEdge.Z && inner.MaxEdge.X <= outer.MaxEdge.X &&
+         inner.MaxEdge.Y <= outer.MaxEdge.Y && inner.MaxEdge.Z <= outer.MaxEdge.Z;
+}
+
+}  // namespace
+
+/* ********************************* A A B B   T R E E ********************************* */
+
+workshop::aabb_tree::aabb_tree(irr::f32 margin) : root_(null_node), free_list_(null_node), margin_(margin) {}
+
+int workshop::aabb_tree::allocate()
+{
+  if (free_list_ == null_node) {
+    nodes_.push_back({});
+    free_list_ = static_cast<int>(nodes_.size()) - 1;
+    nodes_[free_list_].parent = null_node;
+  }
+
+  const int index = free_list_;
+  free_list_ = nodes_[index].parent;
+  nodes_[index] = {irr::core::aabbox3df(), nullptr, null_node, null_node, null_node, 0};
+  return index;
+}
+
+void workshop::aabb_tree::release(int index)
+{
+  nodes_[index].parent = free_list_;
+  nodes_[index].height = -1;
+  free_list_ = index;
+}
+
+int workshop::aabb_tree::insert(const irr::core::aabbox3df& box, void* user_data)
+{
+  const int proxy = allocate();
+  const irr::core::vector3df margin(margin_);
+  nodes_[proxy].box = irr::core::aabbox3df(box.MinEdge - margin, box.MaxEdge + margin);
+  nodes_[proxy].user_data = user_data;
+  insert_leaf(proxy);
+  return proxy;
+}
+
+void workshop::aabb_tree::remove(int proxy)
+{
+  assert(0 <= proxy && proxy < static_cast<int>(nodes_.size()));
+  assert(nodes_[proxy].leaf());
+
+  remove_leaf(proxy);
+  release(proxy);
+}
+
+bool workshop::aabb_tree::move(int proxy, const irr::core::aabbox3df& box)
+{
+  assert(0 <= proxy && proxy < static_cast<int>(nodes_.size()));
+  assert(nodes_[proxy].leaf());
+
+  // small movements stay within the enlarged box
+  if (contains(nodes_[proxy].box, box)) return false;
+
+  remove_leaf(proxy);
+  const irr::core::vector3df margin(margin_);
+  nodes_[proxy].box = irr::core::aabbox3df(box.MinEdge - margin, box.MaxEdge + margin);
+  insert_leaf(proxy);
+  return true;
+}
+
+void* workshop::aabb_tree::user_data(int proxy) const
+{
+  if (proxy < 0 || proxy >= static_cast<int>(nodes_.size()) || !nodes_[proxy].leaf() || nodes_[proxy].height < 0)
+    return nullptr;
+  return nodes_[proxy].user_data;
+}
+
+void workshop::aabb_tree::insert_leaf(int leaf)
+{
+  if (root_ == null_node) {
+    root_ = leaf;
+    nodes_[root_].parent = null_node;
+    return;
+  }
+
+  // find the best sibling by surface area heuristic
+  const irr::core::aabbox3df leaf_box = nodes_[leaf].box;
+  int index = root_;
+  while (!nodes_[index].leaf()) {
+    const int child1 = nodes_[index].child1;
+    const int child2 = nodes_[index].child2;
+
+    const irr::f32 a = area(nodes_[index].box);
+    const irr::f32 combined_area = area(combine(nodes_[index].box, leaf_box));
+
+    // cost of creating a new parent for this node and the new leaf
+    const irr::f32 cost = 2.f * combined_area;
+
+    // minimum cost of pushing the leaf further down the tree
+    const irr::f32 inheritance_cost = 2.f * (combined_area - a);
+
+    auto descend_cost = [&](int child) {
+      const irr::f32 new_area = area(combine(leaf_box, nodes_[child].box));
+      if (nodes_[child].leaf()) return new_area + inheritance_cost;
+      return new_area - area(nodes_[child].box) + inheritance_cost;
+    };
+    const irr::f32 cost1 = descend_cost(child1);
+    const irr::f32 cost2 = descend_cost(child2);
+
+    if (cost < cost1 && cost < cost2) break;
+    index = cost1 < cost2 ? child1 : child2;
+  }
+  const int sibling = index;
+
+  // create a new parent
+  const int old_parent = nodes_[sibling].parent;
+  const int new_parent = allocate();
+  nodes_[new_parent].parent = old_parent;
+  nodes_[new_parent].box = combine(leaf_box, nodes_[sibling].box);
+  nodes_[new_parent].height = nodes_[sibling].height + 1;
+  nodes_[new_parent].child1 = sibling;
+  nodes_[new_parent].child2 = leaf;
+  nodes_[sibling].parent = new_parent;
+  nodes_[leaf].parent = new_parent;
+
+  if (old_parent != null_node) {
+    if (nodes_[old_parent].child1 == sibling)
+      nodes_[old_parent].child1 = new_parent;
+    else
+      nodes_[old_parent].child2 = new_parent;
+  } else
+    root_ = new_parent;
+
+  // walk back up the tree fixing heights and boxes
+  index = nodes_[leaf].parent;
+  while (index != null_node) {
+    index = balance(index);
+    const int child1 = nodes_[index].child1;
+    const int child2 = nodes_[index].child2;
+    nodes_[index].height = 1 + std::max(nodes_[child1].height, nodes_[child2].height);
+    nodes_[index].box = combine(nodes_[child1].box, nodes_[child2].box);
+    index = nodes_[index].parent;
+  }
+}
+
+void workshop::aabb_tree::remove_leaf(int leaf)
+{
+  if (leaf == root_) {
+    root_ = null_node;
+    return;
+  }
+
+  const int parent = nodes_[leaf].parent;
+  const int grand_parent = nodes_[parent].parent;
+  const int sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+
+  if (grand_parent == null_node) {
+    root_ = sibling;
+    nodes_[sibling].parent = null_node;
+    release(parent);
+    return;
+  }
+
+  // destroy parent and connect sibling to grand parent
+  if (nodes_[grand_parent].child1 == parent)
+    nodes_[grand_parent].child1 = sibling;
+  else
+    nodes_[grand_parent].child2 = sibling;
+  nodes_[sibling].parent = grand_parent;
+  release(parent);
+
+  int index = grand_parent;
+  while (index != null_node) {
+    index = balance(index);
+    const int child1 = nodes_[index].child1;
+    const int child2 = nodes_[index].child2;
+    nodes_[index].box = combine(nodes_[child1].box, nodes_[child2].box);
+    nodes_[index].height = 1 + std::max(nodes_[child1].height, nodes_[child2].height);
+    index = nodes_[index].parent;
+  }
+}
+
+int workshop::aabb_tree::balance(int a_index)
+{
+  // rotates node A with its higher child if the tree is imbalanced, returns the new subtree root
+  node& a = nodes_[a_index];
+  if (a.leaf() || a.height < 2) return a_index;
+
+  const int b_index = a.child1;
+  const int c_index = a.child2;
+  const int difference = nodes_[c_index].height - nodes_[b_index].height;
+  if (difference >= -1 && difference <= 1) return a_index;
+
+  // promote the higher child
+  const int up_index = difference > 1 ? c_index : b_index;
+  const int other_index = difference > 1 ? b_index : c_index;
+  node& up = nodes_[up_index];
+  const int f_index = up.child1;
+  const int g_index = up.child2;
+
+  up.child1 = a_index;
+  up.parent = a.parent;
+  a.parent = up_index;
+
+  if (up.parent != null_node) {
+    if (nodes_[up.parent].child1 == a_index)
+      nodes_[up.parent].child1 = up_index;
+    else
+      nodes_[up.parent].child2 = up_index;
+  } else
+    root_ = up_index;
+
+  // higher grandchild stays with the promoted node, the other one goes to A
+  const bool f_higher = nodes_[f_index].height > nodes_[g_index].height;
+  const int keep_index = f_higher ? f_index : g_index;
+  const int move_index = f_higher ? g_index : f_index;
+  up.child2 = keep_index;
+  if (difference > 1)
+    a.child2 = move_index;
+  else
+    a.child1 = move_index;
+  nodes_[move_index].parent = a_index;
+
+  a.box = combine(nodes_[other_index].box, nodes_[move_index].box);
+  up.box = combine(a.box, nodes_[keep_index].box);
+  a.height = 1 + std::max(nodes_[other_index].height, nodes_[move_index].height);
+  up.height = 1 + std::max(a.height, nodes_[keep_index].height);
+
+  return up_index;
+}
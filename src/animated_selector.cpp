@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/animated_selector.h>
+#include <irrlicht-engine/triangle_utils.h>
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace {
+
+std::size_t triangle_count(const irr::scene::IMesh* mesh)
+{
+  std::size_t count = 0;
+  for (irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i) count += mesh->getMeshBuffer(i)->getIndexCount() / 3;
+  return count;
+}
+
+}  // namespace
+
+/* ********************************* A N I M A T E D   S E L E C T O R ********************************* */
+
+workshop::animated_selector::animated_selector(irr::scene::IAnimatedMeshSceneNode* node) :
+    node_(node), frame_(-1.f), count_(0)
+{
+  assert(node);
+
+  // animated meshes keep their buffers and indices in every frame, so they are counted without animating the mesh
+  if (node->getMesh()) count_ = triangle_count(node->getMesh());
+}
+
+workshop::animated_selector::animated_selector(irr::scene::IAnimatedMeshSceneNode* node, triangle_storage&& triangles,
+                                               irr::f32 frame) :
+    node_(node), triangles_(std::move(triangles)), frame_(frame), count_(triangles_.size())
+{
+  assert(node);
+
+  if (frame_ < 0.f && node->getMesh()) count_ = triangle_count(node->getMesh());
+}
+
+void workshop::animated_selector::refit() const
+{
+  const irr::f32 frame = node_->getFrameNr();
+  if (frame == frame_) return;
+  frame_ = frame;
+
+  // the mesh is requested the same way as the node renders it, skinned meshes are animated in place
+  irr::scene::IAnimatedMesh* animated_mesh = node_->getMesh();
+  const irr::s32 blend = static_cast<irr::s32>(irr::core::fract(frame) * 1000.f);
+  irr::scene::IMesh* mesh = animated_mesh ? animated_mesh->getMesh(static_cast<irr::s32>(frame), blend,
+                                                                   node_->getStartFrame(), node_->getEndFrame())
+                                          : nullptr;
+  if (!mesh) {
+    triangles_.clear();
+    count_ = 0;
+    return;
+  }
+
+  // the storage is reused so refits do not allocate once the triangle count is known
+  count_ = triangle_count(mesh);
+  triangles_.resize(count_);
+
+  irr::core::triangle3df* out = triangles_.data();
+  for (irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i) {
+    const irr::scene::IMeshBuffer* buffer = mesh->getMeshBuffer(i);
+    const irr::u32 indices = buffer->getIndexCount() / 3 * 3;
+    for (irr::u32 j = 0; j < indices; j += 3, ++out)
+      out->set(buffer->getPosition(vertex_index(buffer, j)), buffer->getPosition(vertex_index(buffer, j + 1)),
+               buffer->getPosition(vertex_index(buffer, j + 2)));
+  }
+}
+
+bool workshop::animated_selector::intersect(const irr::core::line3df& ray, irr::core::vector3df* point,
+                                            irr::core::triangle3df* triangle) const
+{
+  assert(point);
+  assert(triangle);
+
+  const irr::core::matrix4& world = node_->getAbsoluteTransformation();
+  irr::core::matrix4 inverse;
+  if (!world.getInverse(inverse)) return false;
+
+  // the box of the current frame is tight in mesh space
+  irr::core::line3df local(ray);
+  inverse.transformVect(local.start);
+  inverse.transformVect(local.end);
+  if (!node_->getBoundingBox().intersectsWithLine(local)) return false;
+
+  refit();
+  const irr::core::triangle3df* nearest = nullptr;
+  irr::core::vector3df nearest_point;
+  irr::f32 nearest_distance = 0.f;
+  for (const irr::core::triangle3df& t : triangles_) {
+    irr::core::vector3df p;
+    if (!t.getIntersectionWithLimitedLine(local, p)) continue;
+    const irr::f32 distance = p.getDistanceFromSQ(local.start);
+    if (nearest && distance >= nearest_distance) continue;
+    nearest = &t;
+    nearest_point = p;
+    nearest_distance = distance;
+  }
+  if (!nearest) return false;
+
+  world.transformVect(*point, nearest_point);
+  transform_triangle(world, *nearest, triangle);
+  return true;
+}
+
+void workshop::animated_selector::getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size,
+                                               irr::s32& out_triangle_count, const irr::core::matrix4* transform) const
+{
+  refit();
+
+  irr::core::matrix4 m = node_->getAbsoluteTransformation();
+  if (transform) m = *transform * m;
+
+  out_triangle_count = std::min(array_size, getTriangleCount());
+  for (irr::s32 i = 0; i < out_triangle_count; ++i) transform_triangle(m, triangles_[i], &triangles[i]);
+}
+
+void workshop::animated_selector::getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size,
+                                               irr::s32& out_triangle_count, const irr::core::aabbox3d<irr::f32>& box,
+                                               const irr::core::matrix4* transform) const
+{
+  out_triangle_count = 0;
+
+  // the box is given in world space and the output is additionally transformed, as Irrlicht selectors do
+  irr::core::matrix4 inverse;
+  if (!node_->getAbsoluteTransformation().getInverse(inverse)) return;
+  irr::core::aabbox3df local(box);
+  inverse.transformBoxEx(local);
+
+  refit();
+
+  irr::core::matrix4 m = node_->getAbsoluteTransformation();
+  if (transform) m = *transform * m;
+
+  for (const irr::core::triangle3df& t : triangles_) {
+    if (out_triangle_count == array_size) break;
+    if (t.isTotalOutsideBox(local)) continue;
+    transform_triangle(m, t, &triangles[out_triangle_count++]);
+  }
+}
+
+void workshop::animated_selector::getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size,
+                                               irr::s32& out_triangle_count, const irr::core::line3d<irr::f32>& line,
+                                               const irr::core::matrix4* transform) const
+{
+  irr::core::aabbox3df box(line.start);
+  box.addInternalPoint(line.end);
+  getTriangles(triangles, array_size, out_triangle_count, box, transform);
+}
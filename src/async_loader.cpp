@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/async_loader.h>
+#include <cassert>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+namespace {
+
+std::vector<char> read_file(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return {};
+  return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+/* ********************************* A S Y N C   L O A D E R ********************************* */
+
+workshop::async_loader::async_loader() : stopping_(false) {}
+
+workshop::async_loader::~async_loader()
+{
+  if (active()) stop();
+}
+
+bool workshop::async_loader::start(unsigned workers)
+{
+  assert(!active());
+  assert(workers > 0);
+
+  stopping_ = false;
+  try {
+    for (unsigned i = 0; i < workers; ++i) workers_.emplace_back(&async_loader::run, this);
+  } catch (const std::system_error&) {
+    stop();
+    return false;
+  }
+  return true;
+}
+
+void workshop::async_loader::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  ready_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+  workers_.clear();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.clear();
+  done_.clear();
+}
+
+void workshop::async_loader::submit(load_request* request)
+{
+  assert(request);
+  assert(active());
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(request);
+  }
+  ready_.notify_one();
+}
+
+workshop::load_request* workshop::async_loader::completed()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (done_.empty()) return nullptr;
+  load_request* request = done_.front();
+  done_.pop_front();
+  return request;
+}
+
+void workshop::async_loader::run()
+{
+  for (;;) {
+    load_request* request = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+      if (stopping_) return;
+      request = pending_.front();
+      pending_.pop_front();
+    }
+
+    request->contents.resize(request->paths.size());
+    for (std::size_t i = 0; i < request->paths.size(); ++i) request->contents[i] = read_file(request->paths[i]);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_.push_back(request);
+  }
+}
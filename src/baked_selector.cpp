@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <irrlicht-engine/baked_selector.h>
+#include <irrlicht-engine/triangle_utils.h>
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// spreads the lower 10 bits so that they occupy every third bit
+irr::u32 spread_bits(irr::u32 v)
+{
+  v &= 0x3ff;
+  v = (v | v << 16) & 0x030000ff;
+  v = (v | v << 8) & 0x0300f00f;
+  v = (v | v << 4) & 0x030c30c3;
+  v = (v | v << 2) & 0x09249249;
+  return v;
+}
+
+irr::u32 morton_code(const irr::core::vector3df& p, const irr::core::aabbox3df& bounds)
+{
+  const irr::core::vector3df extent = bounds.getExtent();
+  auto quantize = [](irr::f32 value, irr::f32 min, irr::f32 size) {
+    return size > 0.f ? static_cast<irr::u32>(irr::core::clamp((value - min) / size, 0.f, 1.f) * 1023.f) : 0u;
+  };
+  return spread_bits(quantize(p.X, bounds.MinEdge.X, extent.X)) << 2 |
+         spread_bits(quantize(p.Y, bounds.MinEdge.Y, extent.Y)) << 1 |
+         spread_bits(quantize(p.Z, bounds.MinEdge.Z, extent.Z));
+}
+
+}  // namespace
+
+/* ********************************* B A K E D   S E L E C T O R ********************************* */
+
+void workshop::baked_selector::bake(const irr::scene::IMesh* mesh, data* out)
+{
+  assert(mesh);
+  assert(out);
+
+  std::vector<irr::core::triangle3df> triangles;
+  for (irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i) {
+    const irr::scene::IMeshBuffer* buffer = mesh->getMeshBuffer(i);
+    const irr::u32 indices = buffer->getIndexCount() / 3 * 3;
+    for (irr::u32 j = 0; j < indices; j += 3)
+      triangles.emplace_back(buffer->getPosition(vertex_index(buffer, j)),
+                             buffer->getPosition(vertex_index(buffer, j + 1)),
+                             buffer->getPosition(vertex_index(buffer, j + 2)));
+  }
+
+  out->triangles.clear();
+  out->clusters.clear();
+  if (triangles.empty()) return;
+
+  // neighbouring triangles end up in the same cluster when sorted by the Morton code of their centers
+  irr::core::aabbox3df bounds(triangles.front().pointA);
+  for (const irr::core::triangle3df& t : triangles) {
+    bounds.addInternalPoint(t.pointA);
+    bounds.addInternalPoint(t.pointB);
+    bounds.addInternalPoint(t.pointC);
+  }
+  std::vector<std::pair<irr::u32, irr::u32>> order(triangles.size());
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    const irr::core::triangle3df& t = triangles[i];
+    order[i] = {morton_code((t.pointA + t.pointB + t.pointC) / 3.f, bounds), static_cast<irr::u32>(i)};
+  }
+  std::sort(order.begin(), order.end());
+
+  out->triangles.reserve(triangles.size());
+  for (const std::pair<irr::u32, irr::u32>& o : order) out->triangles.push_back(triangles[o.second]);
+
+  out->clusters.reserve((triangles.size() + cluster_size - 1) / cluster_size);
+  for (irr::u32 first = 0; first < out->triangles.size(); first += cluster_size) {
+    const irr::u32 count = std::min(cluster_size, static_cast<irr::u32>(out->triangles.size()) - first);
+    irr::core::aabbox3df box(out->triangles[first].pointA);
+    for (irr::u32 i = first; i < first + count; ++i) {
+      box.addInternalPoint(out->triangles[i].pointA);
+      box.addInternalPoint(out->triangles[i].pointB);
+      box.addInternalPoint(out->triangles[i].pointC);
+    }
+    out->clusters.push_back({box, first, count});
+  }
+}
+
+workshop::baked_selector::baked_selector(irr::scene::ISceneNode* node, data&& baked) :
+    node_(node), data_(std::move(baked))
+{
+  assert(node);
+}
+
+void workshop::baked_selector::getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size,
+                                            irr::s32& out_triangle_count, const irr::core::matrix4* transform) const
+{
+  irr::core::matrix4 m = node_->getAbsoluteTransformation();
+  if (transform) m = *transform * m;
+
+  out_triangle_count = std::min(array_size, getTriangleCount());
+  for (irr::s32 i = 0; i < out_triangle_count; ++i) transform_triangle(m, data_.triangles[i], &triangles[i]);
+}
+
+void workshop::baked_selector::getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size,
+                                            irr::s32& out_triangle_count, const irr::core::aabbox3d<irr::f32>& box,
+                                            const irr::core::matrix4* transform) const
+{
+  out_triangle_count = 0;
+
+  // the box is given in world space and the output is additionally transformed, as Irrlicht selectors do
+  irr::core::matrix4 inverse;
+  if (!node_->getAbsoluteTransformation().getInverse(inverse)) return;
+  irr::core::aabbox3df local(box);
+  inverse.transformBoxEx(local);
+
+  irr::core::matrix4 m = node_->getAbsoluteTransformation();
+  if (transform) m = *transform * m;
+
+  for (const cluster& c : data_.clusters) {
+    if (!c.box.intersectsWithBox(local)) continue;
+    for (irr::u32 i = c.first; i < c.first + c.count; ++i) {
+      if (out_triangle_count == array_size) return;
+      if (data_.triangles[i].isTotalOutsideBox(local)) continue;
+      transform_triangle(m, data_.triangles[i], &triangles[out_triangle_count++]);
+    }
+  }
+}
+
+void workshop::baked_selector::getTriangles(irr::core::triangle3df* triangles, irr::s32 array_size,
+                                            irr::s32& out_triangle_count, const irr::core::line3d<irr::f32>& line,
+                                            const irr::core::matrix4* transform) const
+{
+  irr::core::aabbox3df box(line.start);
+  box.addInternalPoint(line.end);
+  getTriangles(triangles, array_size, out_triangle_count, box, transform);
+}
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/collision.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace {
+
+const int max_recursion_depth = 5;
+const irr::f32 very_close_distance = 0.0005f;  // Irrlicht's default sliding value
+const irr::f32 no_contact = 2.f;               // t0 sentinel outside of the [0, 1] sweep interval
+
+// lowest root of a*t^2 + b*t + c = 0 in (0, max_root)
+bool lowest_root(irr::f32 a, irr::f32 b, irr::f32 c, irr::f32 max_root, irr::f32& root)
+{
+  const irr::f32 determinant = b * b - 4.f * a * c;
+  if (determinant < 0.f || a == 0.f) return false;
+
+  const irr::f32 sqrt_d = std::sqrt(determinant);
+  irr::f32 r1 = (-b - sqrt_d) / (2.f * a);
+  irr::f32 r2 = (-b + sqrt_d) / (2.f * a);
+  if (r1 > r2) std::swap(r1, r2);
+
+  if (r1 > 0.f && r1 < max_root) {
+    root = r1;
+    return true;
+  }
+  if (r2 > 0.f && r2 < max_root) {
+    root = r2;
+    return true;
+  }
+  return false;
+}
+
+bool point_in_triangle(const irr::core::vector3df& p, const irr::core::vector3df& a, const irr::core::vector3df& b,
+                       const irr::core::vector3df& c)
+{
+  const irr::core::vector3df v0 = c - a;
+  const irr::core::vector3df v1 = b - a;
+  const irr::core::vector3df v2 = p - a;
+  const irr::f32 d00 = v0.dotProduct(v0);
+  const irr::f32 d01 = v0.dotProduct(v1);
+  const irr::f32 d02 = v0.dotProduct(v2);
+  const irr::f32 d11 = v1.dotProduct(v1);
+  const irr::f32 d12 = v1.dotProduct(v2);
+  const irr::f32 denominator = d00 * d11 - d01 * d01;
+  if (denominator == 0.f) return false;
+
+  const irr::f32 u = (d11 * d02 - d01 * d12) / denominator;
+  const irr::f32 v = (d00 * d12 - d01 * d02) / denominator;
+  return u >= 0.f && v >= 0.f && u + v <= 1.f;
+}
+
+}  // namespace
+
+/* ********************************* C O L L I S I O N   W O R L D ********************************* */
+
+workshop::collision_world::collision_world() : level_(nullptr), soa_{} {}
+
+workshop::collision_world::~collision_world()
+{
+  if (level_) level_->drop();
+}
+
+void workshop::collision_world::level(irr::scene::ITriangleSelector* selector)
+{
+  if (selector) selector->grab();
+  if (level_) level_->drop();
+  level_ = selector;
+}
+
+bool workshop::collision_world::add(irr::scene::ISceneNode* node, const irr::core::vector3df& radius,
+                                    const irr::core::vector3df& gravity, const irr::core::vector3df& translation)
+{
+  assert(node);
+
+  if (radius.X <= 0.f || radius.Y <= 0.f || radius.Z <= 0.f) return false;
+  remove(node);
+  agents_.push_back({node, radius, gravity, translation, node->getPosition(), irr::core::vector3df(), 0, false, true});
+  return true;
+}
+
+void workshop::collision_world::remove(irr::scene::ISceneNode* node)
+{
+  agents_.erase(
+    std::remove_if(agents_.begin(), agents_.end(), [&](const agent& a) { return a.node == node; }),
+    agents_.end());
+}
+
+void workshop::collision_world::jump(irr::scene::ISceneNode* node, irr::f32 speed)
+{
+  for (agent& a : agents_) {
+    if (a.node != node || a.falling) continue;
+    irr::core::vector3df up = a.gravity;
+    a.falling_velocity -= up.normalize() * speed;
+    a.falling = true;
+  }
+}
+
+void workshop::collision_world::update(irr::u32 time_ms)
+{
+  for (agent& a : agents_) resolve(a, time_ms);
+}
+
+void workshop::collision_world::resolve(agent& a, irr::u32 time_ms)
+{
+  if (a.first_update) {
+    // do not sweep from the origin to the position the node was placed at
+    a.last_position = a.node->getPosition();
+    a.last_time = time_ms;
+    a.first_update = false;
+    return;
+  }
+
+  const irr::u32 diff = time_ms - a.last_time;
+  a.last_time = time_ms;
+
+  const irr::core::vector3df position = a.node->getPosition();
+  const irr::core::vector3df velocity = position - a.last_position;
+  a.falling_velocity += a.gravity * static_cast<irr::f32>(diff) * 0.001f;
+
+  const irr::core::vector3df zero;
+  if (!level_ || (velocity == zero && a.falling_velocity == zero)) {
+    a.last_position = position;
+    return;
+  }
+
+  // a sliding sweep never gets further from its start than the requested distance so one query covers all iterations
+  const irr::core::vector3df start = a.last_position - a.translation;
+  const irr::f32 reach = velocity.getLength() + a.falling_velocity.getLength();
+  irr::core::aabbox3df box(start);
+  box.MinEdge -= a.radius + irr::core::vector3df(reach);
+  box.MaxEdge += a.radius + irr::core::vector3df(reach);
+  gather(box, a.radius);
+
+  int hits = 0;
+  irr::core::vector3df result = collide(start / a.radius, velocity / a.radius, 0, hits);
+
+  bool falling = false;
+  if (a.falling_velocity != zero) {
+    hits = 0;
+    result = collide(result, a.falling_velocity / a.radius, 0, hits);
+    falling = hits == 0;
+  }
+  result = result * a.radius + a.translation;
+
+  a.falling = falling;
+  if (!falling) a.falling_velocity = zero;
+
+  a.node->setPosition(result);
+  if (a.node->getType() == irr::scene::ESNT_CAMERA) {
+    // keep the camera looking in the same direction
+    irr::scene::ICameraSceneNode* camera = static_cast<irr::scene::ICameraSceneNode*>(a.node);
+    camera->setTarget(camera->getTarget() + (result - position));
+  }
+  a.node->updateAbsolutePosition();
+  a.last_position = result;
+}
+
+void workshop::collision_world::gather(const irr::core::aabbox3df& box, const irr::core::vector3df& radius)
+{
+  assert(level_);
+
+  const irr::s32 capacity = level_->getTriangleCount();
+  if (triangles_.size() < static_cast<std::size_t>(capacity)) triangles_.resize(static_cast<std::size_t>(capacity));
+
+  irr::s32 count = 0;
+  level_->getTriangles(triangles_.data(), capacity, count, box);
+
+  const std::size_t n = static_cast<std::size_t>(count);
+  if (soa_.ax.size() < n) {
+    for (tracked_vector<irr::f32>* v : {&soa_.ax, &soa_.ay, &soa_.az, &soa_.bx, &soa_.by, &soa_.bz, &soa_.cx, &soa_.cy,
+                                     &soa_.cz, &soa_.nx, &soa_.ny, &soa_.nz, &soa_.d, &soa_.t0})
+      v->resize(n);
+  }
+  soa_.size = static_cast<irr::u32>(n);
+
+  // transform to ellipsoid space where the agent is a unit sphere
+  const irr::core::vector3df inv(1.f / radius.X, 1.f / radius.Y, 1.f / radius.Z);
+  for (std::size_t i = 0; i < n; ++i) {
+    const irr::core::vector3df a = triangles_[i].pointA * inv;
+    const irr::core::vector3df b = triangles_[i].pointB * inv;
+    const irr::core::vector3df c = triangles_[i].pointC * inv;
+    irr::core::vector3df normal = (b - a).crossProduct(c - a);
+    const irr::f32 length = normal.getLength();
+    if (length > 0.f) normal = normal / length;
+
+    soa_.ax[i] = a.X, soa_.ay[i] = a.Y, soa_.az[i] = a.Z;
+    soa_.bx[i] = b.X, soa_.by[i] = b.Y, soa_.bz[i] = b.Z;
+    soa_.cx[i] = c.X, soa_.cy[i] = c.Y, soa_.cz[i] = c.Z;
+    soa_.nx[i] = normal.X, soa_.ny[i] = normal.Y, soa_.nz[i] = normal.Z;
+    // degenerate triangles get a plane that can never be touched
+    soa_.d[i] = length > 0.f ? -normal.dotProduct(a) : std::numeric_limits<irr::f32>::max();
+  }
+}
+
+irr::core::vector3df workshop::collision_world::collide(const irr::core::vector3df& position,
+                                                        const irr::core::vector3df& velocity, int depth, int& hits)
+{
+  if (depth > max_recursion_depth) return position;
+
+  // branch-free plane interval test over all candidates, written so that the compiler can vectorize it
+  const irr::f32 px = position.X, py = position.Y, pz = position.Z;
+  const irr::f32 vx = velocity.X, vy = velocity.Y, vz = velocity.Z;
+  const irr::f32* nx = soa_.nx.data();
+  const irr::f32* ny = soa_.ny.data();
+  const irr::f32* nz = soa_.nz.data();
+  const irr::f32* d = soa_.d.data();
+  irr::f32* t0 = soa_.t0.data();
+  for (irr::u32 i = 0; i < soa_.size; ++i) {
+    const irr::f32 distance = nx[i] * px + ny[i] * py + nz[i] * pz + d[i];
+    const irr::f32 speed = nx[i] * vx + ny[i] * vy + nz[i] * vz;
+    const bool parallel = std::fabs(speed) < 1e-6f;
+    const irr::f32 inv_speed = parallel ? 0.f : 1.f / speed;
+    const irr::f32 ta = (-1.f - distance) * inv_speed;
+    const irr::f32 tb = (1.f - distance) * inv_speed;
+    const irr::f32 enter = std::min(ta, tb);
+    const irr::f32 leave = std::max(ta, tb);
+    const bool touches = parallel ? std::fabs(distance) < 1.f : enter <= 1.f && leave >= 0.f;
+    // only front facing triangles can be hit
+    t0[i] = speed <= 0.f && touches ? (parallel ? 0.f : std::max(enter, 0.f)) : no_contact;
+  }
+
+  // exact test only for triangles whose plane is reached earlier than the nearest hit found so far
+  const irr::f32 length = velocity.getLength();
+  irr::f32 nearest_distance = std::numeric_limits<irr::f32>::max();
+  irr::core::vector3df intersection;
+  bool found = false;
+  for (irr::u32 i = 0; i < soa_.size; ++i) {
+    if (t0[i] > 1.f || t0[i] * length >= nearest_distance) continue;
+    irr::f32 t = 1.f;
+    irr::core::vector3df point;
+    if (!sweep(i, position, velocity, t, point)) continue;
+    const irr::f32 distance = t * length;
+    if (distance < nearest_distance) {
+      nearest_distance = distance;
+      intersection = point;
+      found = true;
+    }
+  }
+
+  if (!found) return position + velocity;
+  ++hits;
+
+  // move close to the contact point and slide along the plane touching the sphere
+  const irr::core::vector3df destination = position + velocity;
+  irr::core::vector3df base = position;
+  if (nearest_distance >= very_close_distance) {
+    irr::core::vector3df v = velocity;
+    v.setLength(nearest_distance - very_close_distance);
+    base = position + v;
+    v.normalize();
+    intersection -= v * very_close_distance;
+  }
+
+  irr::core::vector3df slide_normal = base - intersection;
+  slide_normal.normalize();
+  const irr::core::plane3df slide_plane(intersection, slide_normal);
+  const irr::core::vector3df new_destination = destination - slide_normal * slide_plane.getDistanceTo(destination);
+  const irr::core::vector3df new_velocity = new_destination - intersection;
+  if (new_velocity.getLength() < very_close_distance) return base;
+
+  return collide(base, new_velocity, depth + 1, hits);
+}
+
+bool workshop::collision_world::sweep(irr::u32 i, const irr::core::vector3df& base,
+                                      const irr::core::vector3df& velocity, irr::f32& t,
+                                      irr::core::vector3df& point) const
+{
+  const irr::core::vector3df a(soa_.ax[i], soa_.ay[i], soa_.az[i]);
+  const irr::core::vector3df b(soa_.bx[i], soa_.by[i], soa_.bz[i]);
+  const irr::core::vector3df c(soa_.cx[i], soa_.cy[i], soa_.cz[i]);
+  const irr::core::vector3df normal(soa_.nx[i], soa_.ny[i], soa_.nz[i]);
+
+  // the sphere touches the inside of the triangle when it enters its plane
+  const bool embedded = std::fabs(normal.dotProduct(velocity)) < 1e-6f;
+  if (!embedded) {
+    const irr::core::vector3df plane_point = base - normal + velocity * soa_.t0[i];
+    if (point_in_triangle(plane_point, a, b, c)) {
+      t = soa_.t0[i];
+      point = plane_point;
+      return true;
+    }
+  }
+
+  // otherwise sweep against vertices and edges
+  bool found = false;
+  const irr::f32 velocity_length_sq = velocity.getLengthSQ();
+  irr::f32 root;
+
+  for (const irr::core::vector3df* vertex : {&a, &b, &c}) {
+    const irr::f32 vb = 2.f * velocity.dotProduct(base - *vertex);
+    const irr::f32 vc = (*vertex - base).getLengthSQ() - 1.f;
+    if (lowest_root(velocity_length_sq, vb, vc, t, root)) {
+      t = root;
+      point = *vertex;
+      found = true;
+    }
+  }
+
+  const irr::core::vector3df* edges[][2] = {{&a, &b}, {&b, &c}, {&c, &a}};
+  for (const auto& e : edges) {
+    const irr::core::vector3df edge = *e[1] - *e[0];
+    const irr::core::vector3df base_to_vertex = *e[0] - base;
+    const irr::f32 edge_length_sq = edge.getLengthSQ();
+    const irr::f32 edge_dot_velocity = edge.dotProduct(velocity);
+    const irr::f32 edge_dot_base_to_vertex = edge.dotProduct(base_to_vertex);
+
+    const irr::f32 ea = edge_length_sq * -velocity_length_sq + edge_dot_velocity * edge_dot_velocity;
+    const irr::f32 eb = edge_length_sq * (2.f * velocity.dotProduct(base_to_vertex)) -
+                        2.f * edge_dot_velocity * edge_dot_base_to_vertex;
+    const irr::f32 ec = edge_length_sq * (1.f - base_to_vertex.getLengthSQ()) +
+                        edge_dot_base_to_vertex * edge_dot_base_to_vertex;
+    if (lowest_root(ea, eb, ec, t, root)) {
+      // check if intersection is within the segment
+      const irr::f32 f = (edge_dot_velocity * root - edge_dot_base_to_vertex) / edge_length_sq;
+      if (f >= 0.f && f <= 1.f) {
+        t = root;
+        point = *e[0] + edge * f;
+        found = true;
+      }
+    }
+  }
+
+  return found;
+}
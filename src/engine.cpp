@@ -26,8 +26,14 @@
  */
 
 #include <irrlicht-engine/engine.h>
+#include <irrlicht-engine/snapshot.h>
+#include <irrlicht-engine/trace.h>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
 #include <string>
+#include <utility>
 
 namespace {
 
@@ -35,6 +41,99 @@ enum { id_flag_not_pickable = 0, id_flag_is_pickable = 1 << 0, id_flag_is_highli
 
 const std::wstring workshop_title = L"Modern C++ Design - Part I";
 
+// media files of objects relative to the Irrlicht media directory
+const char* const mesh_files[workshop::object_handle::type_num] = {"/faerie.md2", "/ninja.b3d", "/dwarf.x",
+                                                                   "/yodan.mdl"};
+const char* const type_names[workshop::object_handle::type_num] = {"faerie", "ninja", "dwarf", "yodan"};
+const char* const faerie_texture_file = "/faerie2.bmp";
+// textures read with the meshes, the faerie one is set by resource_set() and the others are referenced by the mesh
+// files, yodan skins are embedded in its mesh
+const char* const object_texture_files[workshop::object_handle::type_num][2] = {
+  {faerie_texture_file, nullptr}, {"/nskinbl.jpg", nullptr}, {"/dwarf.jpg", "/axe.jpg"}, {nullptr, nullptr}};
+const char* const laser_texture_file = "/particle.bmp";
+const char* const font_file = "/fonthaettenschweiler.bmp";
+
+const unsigned loader_workers = 2;   // threads reading media files of spawned objects
+const int max_spawns_per_frame = 1;  // objects created at the end of a single frame
+
+irr::scene::IAnimatedMesh* load_mesh(irr::scene::ISceneManager* smgr, const std::string& path)
+{
+  workshop::trace_scope scope("getMesh", path);
+  return smgr->getMesh(path.c_str());
+}
+
+irr::video::ITexture* load_texture(irr::video::IVideoDriver* driver, workshop::texture_cache& cache,
+                                   const std::string& path)
+{
+  workshop::trace_scope scope("getTexture", path);
+  irr::video::ITexture* texture = cache.get_texture(path);
+  return texture ? texture : driver->getTexture(path.c_str());
+}
+
+const irr::f32 spatial_index_margin = 20.f;  // enlargement of object boxes in the spatial index
+
+// camera ellipsoid of the collision resolver
+const irr::core::vector3df camera_radius(30, 50, 30);
+const irr::core::vector3df camera_gravity(0, -10, 0);
+const irr::core::vector3df camera_translation(0, 30, 0);
+
+bool box_intersects_sphere(const irr::core::aabbox3df& box, const irr::core::vector3df& center, irr::f32 radius)
+{
+  // distance from the sphere center to the closest point of the box
+  const irr::core::vector3df closest(irr::core::clamp(center.X, box.MinEdge.X, box.MaxEdge.X),
+                                     irr::core::clamp(center.Y, box.MinEdge.Y, box.MaxEdge.Y),
+                                     irr::core::clamp(center.Z, box.MinEdge.Z, box.MaxEdge.Z));
+  return closest.getDistanceFromSQ(center) <= radius * radius;
+}
+
+bool box_intersects_box(const irr::core::aabbox3df& a, const irr::core::aabbox3df& b)
+{
+  return a.MinEdge.X <= b.MaxEdge.X && b.MinEdge.X <= a.MaxEdge.X && a.MinEdge.Y <= b.MaxEdge.Y &&
+         b.MinEdge.Y <= a.MaxEdge.Y && a.MinEdge.Z <= b.MaxEdge.Z && b.MinEdge.Z <= a.MaxEdge.Z;
+}
+
+bool box_intersects_frustum(const irr::core::aabbox3df& box, const irr::scene::SViewFrustum& frustum)
+{
+  // frustum planes point outwards so the box is outside if its nearest corner is in front of any plane
+  for (int i = 0; i < irr::scene::SViewFrustum::VF_PLANE_COUNT; ++i) {
+    const irr::core::plane3df& plane = frustum.planes[i];
+    const irr::core::vector3df nearest(plane.Normal.X >= 0 ? box.MinEdge.X : box.MaxEdge.X,
+                                       plane.Normal.Y >= 0 ? box.MinEdge.Y : box.MaxEdge.Y,
+                                       plane.Normal.Z >= 0 ? box.MinEdge.Z : box.MaxEdge.Z);
+    if (plane.Normal.dotProduct(nearest) + plane.D > 0) return false;
+  }
+  return true;
+}
+
+float milliseconds(std::chrono::steady_clock::duration d)
+{
+  return std::chrono::duration<float, std::milli>(d).count();
+}
+
+std::size_t texture_memory(irr::video::ITexture* texture)
+{
+  // mipmap chain adds one third of the base level
+  const std::size_t size = static_cast<std::size_t>(texture->getPitch()) * texture->getSize().Height;
+  return texture->hasMipMaps() ? size * 4 / 3 : size;
+}
+
+std::size_t mesh_memory(const irr::scene::IMesh* mesh)
+{
+  // vertex and index data only, animated meshes may keep more frames or joints
+  std::size_t size = 0;
+  for (irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i) {
+    const irr::scene::IMeshBuffer* buffer = mesh->getMeshBuffer(i);
+    std::size_t vertex_size = sizeof(irr::video::S3DVertex);
+    if (buffer->getVertexType() == irr::video::EVT_2TCOORDS)
+      vertex_size = sizeof(irr::video::S3DVertex2TCoords);
+    else if (buffer->getVertexType() == irr::video::EVT_TANGENTS)
+      vertex_size = sizeof(irr::video::S3DVertexTangents);
+    const std::size_t index_size = buffer->getIndexType() == irr::video::EIT_16BIT ? 2 : 4;
+    size += buffer->getVertexCount() * vertex_size + buffer->getIndexCount() * index_size;
+  }
+  return size;
+}
+
 }  // namespace
 
 /* ********************************* S E L E C T O R ********************************* */
@@ -49,7 +148,21 @@ int workshop::selector::init(engine* e, object_handle* object)
   workshop::engine::irr_runtime* r = e->runtime();
   assert(r->smgr);
 
-  resource_ = r->smgr->createTriangleSelector(object->resource_);
+  trace_scope scope("selector::init", object->resource_->getName());
+  resource_ = new (std::nothrow) animated_selector(object->resource_);
+  if (!resource_) return SELECTOR_INIT_FAIL;
+  return SELECTOR_INIT_SUCCESS;
+}
+
+int workshop::selector::init(engine* e, object_handle* object, animated_selector::triangle_storage&& triangles,
+                             irr::f32 frame)
+{
+  assert(resource_ == nullptr);
+  assert(e);
+  assert(object);
+  assert(object->resource_);
+
+  resource_ = new (std::nothrow) animated_selector(object->resource_, std::move(triangles), frame);
   if (!resource_) return SELECTOR_INIT_FAIL;
   return SELECTOR_INIT_SUCCESS;
 }
@@ -76,6 +189,8 @@ bool workshop::object_handle::resource_set(engine* e)
   assert(resource_ == nullptr);
   assert(e);
 
+  trace_scope scope("object_handle::resource_set", [this] { return name_ ? *name_ : std::string(); });
+
   workshop::engine::irr_runtime* r = e->runtime();
   assert(r->smgr);
   assert(r->driver);
@@ -83,13 +198,13 @@ bool workshop::object_handle::resource_set(engine* e)
   switch (type_) {
     case type_faerie: {
       // add an MD2 node, which uses vertex-based animation
-      irr::scene::IAnimatedMesh* mesh = r->smgr->getMesh((e->irrlicht_media_path() + "/faerie.md2").c_str());
+      irr::scene::IAnimatedMesh* mesh = load_mesh(r->smgr, e->irrlicht_media_path() + mesh_files[type_]);
       if (!mesh) return false;
       resource_ = r->smgr->addAnimatedMeshSceneNode(mesh, 0, id_flag_is_pickable | id_flag_is_highlightable);
       resource_->setScale(irr::core::vector3df(1.6f));
       resource_->setMD2Animation(irr::scene::EMAT_POINT);
       resource_->setAnimationSpeed(20.f);
-      irr::video::ITexture* tex = r->driver->getTexture((e->irrlicht_media_path() + "/faerie2.bmp").c_str());
+      irr::video::ITexture* tex = load_texture(r->driver, e->textures_, e->irrlicht_media_path() + faerie_texture_file);
       if (!tex) {
         resource_ = nullptr;
         return false;
@@ -104,7 +219,7 @@ bool workshop::object_handle::resource_set(engine* e)
 
     case type_ninja: {
       // this B3D file uses skinned skeletal animation
-      irr::scene::IAnimatedMesh* mesh = r->smgr->getMesh((e->irrlicht_media_path() + "/ninja.b3d").c_str());
+      irr::scene::IAnimatedMesh* mesh = load_mesh(r->smgr, e->irrlicht_media_path() + mesh_files[type_]);
       if (!mesh) return false;
       resource_ = r->smgr->addAnimatedMeshSceneNode(mesh, 0, id_flag_is_pickable | id_flag_is_highlightable);
       resource_->setScale(irr::core::vector3df(10));
@@ -116,7 +231,7 @@ bool workshop::object_handle::resource_set(engine* e)
 
     case type_dwarf: {
       // this X file uses skeletal animation, but without skinning
-      irr::scene::IAnimatedMesh* mesh = r->smgr->getMesh((e->irrlicht_media_path() + "/dwarf.x").c_str());
+      irr::scene::IAnimatedMesh* mesh = load_mesh(r->smgr, e->irrlicht_media_path() + mesh_files[type_]);
       if (!mesh) return false;
       resource_ = r->smgr->addAnimatedMeshSceneNode(mesh, 0, id_flag_is_pickable | id_flag_is_highlightable);
       resource_->setAnimationSpeed(20.f);
@@ -126,7 +241,7 @@ bool workshop::object_handle::resource_set(engine* e)
 
     case type_yodan: {
       // this mdl file uses skinned skeletal animation
-      irr::scene::IAnimatedMesh* mesh = r->smgr->getMesh((e->irrlicht_media_path() + "/yodan.mdl").c_str());
+      irr::scene::IAnimatedMesh* mesh = load_mesh(r->smgr, e->irrlicht_media_path() + mesh_files[type_]);
       if (!mesh) return false;
       resource_ = r->smgr->addAnimatedMeshSceneNode(mesh, 0, id_flag_is_pickable | id_flag_is_highlightable);
       resource_->setScale(irr::core::vector3df(0.8f));
@@ -143,10 +258,22 @@ bool workshop::object_handle::resource_set(engine* e)
       assert(0);
   }
 
+  if (resource_) {
+    e->render_queue_.add(resource_);
+    e->track(this);
+  }
   return true;
 }
 
-workshop::object_handle::object_handle(type t, const std::string* name) : type_(t), name_(name), resource_(nullptr) {}
+workshop::object_handle::object_handle(type t, const std::string* name) :
+    type_(t), name_(name), resource_(nullptr), engine_(nullptr), proxy_(aabb_tree::null_node), selector_(nullptr)
+{
+}
+
+workshop::object_handle::~object_handle()
+{
+  if (engine_) engine_->untrack(this);
+}
 
 bool workshop::object_handle::resource_set(irr::scene::IAnimatedMeshSceneNode* resource)
 {
@@ -162,6 +289,7 @@ void workshop::object_handle::position(float x, float y, float z)
   assert(resource_);
 
   resource_->setPosition(irr::core::vector3df(x, y, z));
+  if (engine_) engine_->refit(this);
 }
 
 void workshop::object_handle::rotation(float x, float y, float z)
@@ -172,6 +300,7 @@ void workshop::object_handle::rotation(float x, float y, float z)
   assert(-180 <= z && z <= 180);
 
   resource_->setRotation(irr::core::vector3df(x, y, z));
+  if (engine_) engine_->refit(this);
 }
 
 void workshop::object_handle::selector(workshop::selector* s)
@@ -180,7 +309,12 @@ void workshop::object_handle::selector(workshop::selector* s)
   assert(s);
   assert(s->resource_);
 
+  // copies of a tracked object share its proxy but their selectors are not counted
+  const bool tracked = engine_ && engine_->objects_.user_data(proxy_) == this;
+  if (tracked && selector_) engine_->remove_selector(selector_);
   resource_->setTriangleSelector(s->resource_);
+  selector_ = s->resource_;
+  if (tracked) engine_->add_selector(selector_);
 }
 
 void workshop::object_handle::highlight(bool select)
@@ -197,28 +331,32 @@ void workshop::object_handle::name(std::string* name) const
   *name = resource_->getName();
 }
 
+/* ********************************* S P A W N   O P E R A T I O N ********************************* */
+
+workshop::spawn_operation::spawn_operation(engine* e, object_handle::type t, std::string name) :
+    engine_(e), type_(t), name_(std::move(name)), request_{{}, {}, this}, object_(nullptr)
+{
+  assert(e);
+  assert(0 <= t && t < object_handle::type_num);
+}
+
+bool workshop::spawn_operation::await_suspend(std::coroutine_handle<> continuation)
+{
+  continuation_ = continuation;
+  return engine_->spawn(this);
+}
+
 /* ********************************* C A M E R A ********************************* */
 
-int workshop::camera::init(irr::scene::ISceneManager* smgr, irr::scene::IMeshSceneNode* level)
+int workshop::camera::init(irr::scene::ISceneManager* smgr)
 {
   assert(resource_ == nullptr);
   assert(smgr);
-  assert(level);
 
+  // collision with the level is resolved by the engine
   resource_ = smgr->addCameraSceneNodeFPS(0, 50.0f, .3f, id_flag_not_pickable, 0, 0, true, 2.f);
   if (!resource_) return 1;
 
-  irr::scene::ISceneNodeAnimator* anim =
-    smgr->createCollisionResponseAnimator(level->getTriangleSelector(), resource_, irr::core::vector3df(30, 50, 30),
-                                          irr::core::vector3df(0, -10, 0), irr::core::vector3df(0, 30, 0));
-  if (!anim) {
-    resource_ = nullptr;
-    return 2;
-  }
-
-  resource_->addAnimator(anim);
-  anim->drop();
-
   return 0;
 }
 
@@ -243,8 +381,12 @@ void workshop::camera::target(float x, float y, float z)
 bool workshop::engine::event_receiver::OnEvent(const irr::SEvent& event)
 {
   // Remember whether each key is down or up
-  if (event.EventType == irr::EET_KEY_INPUT_EVENT)
-    if (event.KeyInput.PressedDown && event.KeyInput.Key == irr::KEY_KEY_Q) quit_ = true;
+  if (event.EventType == irr::EET_KEY_INPUT_EVENT && event.KeyInput.PressedDown) {
+    if (event.KeyInput.Key == irr::KEY_KEY_Q) quit_ = true;
+    if (event.KeyInput.Key == irr::KEY_KEY_J) jump_ = true;  // default FPS camera jump key
+  }
+  // the engine stops a failed recording at the next frame
+  if (log_ && log_->state() == input_log::mode_record && !log_->write_event(event)) log_ = nullptr;
   return false;
 }
 
@@ -273,15 +415,26 @@ int workshop::engine::init_device(irr::u32 width, irr::u32 height, irr::u32 bpp,
   assert(runtime_.smgr == nullptr);
   assert(event_receiver_);
 
+  trace_scope scope("engine::init_device");
+
   // create Irrlicht device - the most important object of the engine
-  device_ = irr::createDevice(convert(device_type_), irr::core::dimension2d<irr::u32>(width, height), bpp, full_screen,
-                              stencil, vsync, event_receiver_);
+  {
+    trace_scope device_scope("createDevice");
+    device_ = irr::createDevice(convert(device_type_), irr::core::dimension2d<irr::u32>(width, height), bpp,
+                                full_screen, stencil, vsync, event_receiver_);
+  }
   if (!device_) return 2;
 
   runtime_.smgr = device_->getSceneManager();
 
   // add Quake 3 map resources to Irrlicht local file system
-  if (!device_->getFileSystem()->addFileArchive((irrlicht_media_path() + "/map-20kdm2.pk3").c_str())) {
+  bool archive_added = false;
+  {
+    const std::string archive = irrlicht_media_path() + "/map-20kdm2.pk3";
+    trace_scope archive_scope("addFileArchive", archive);
+    archive_added = device_->getFileSystem()->addFileArchive(archive.c_str());
+  }
+  if (!archive_added) {
     device_->drop();
     device_ = nullptr;
     return 3;
@@ -295,23 +448,168 @@ int workshop::engine::init_device(irr::u32 width, irr::u32 height, irr::u32 bpp,
   return 0;
 }
 
+bool workshop::engine::use_texture_cache(const std::string& path)
+{
+  assert(device_);
+
+  trace_scope scope("engine::use_texture_cache", path);
+
+  if (!runtime_.driver) runtime_.driver = device_->getVideoDriver();
+  irr::io::IFileSystem* fs = device_->getFileSystem();
+  if (textures_.open(path, runtime_.driver, fs)) return true;
+
+  // textures are decoded and converted by the driver once, font bitmaps are stored as decoded
+  texture_cache baked;
+  for (const char* file : {faerie_texture_file, laser_texture_file}) {
+    irr::video::ITexture* texture = runtime_.driver->getTexture((irrlicht_media_path() + file).c_str());
+    if (!texture || !baked.add(irrlicht_media_path() + file, texture)) return false;
+  }
+  irr::video::IImage* image = runtime_.driver->createImageFromFile((irrlicht_media_path() + font_file).c_str());
+  if (!image) return false;
+  const bool added = baked.add(irrlicht_media_path() + font_file, image);
+  image->drop();
+
+  return added && baked.write(path, runtime_.driver) && textures_.open(path, runtime_.driver, fs);
+}
+
 bool workshop::engine::font()
 {
   assert(font_ == nullptr);
 
+  trace_scope scope("engine::font", [this] { return irrlicht_media_path() + font_file; });
+
   // load custom font
   if (!runtime_.guienv) {
     assert(device_);
     runtime_.guienv = device_->getGUIEnvironment();
   }
-  font_ = runtime_.guienv->getFont((irrlicht_media_path() + "/fonthaettenschweiler.bmp").c_str());
+  // a baked font bitmap is served to the font loader by the texture cache
+  font_ = runtime_.guienv->getFont((irrlicht_media_path() + font_file).c_str());
   return font_ != nullptr;
 }
 
+workshop::spawn_operation workshop::engine::spawn_async(object_handle::type t, std::string name)
+{
+  return spawn_operation(this, t, std::move(name));
+}
+
+bool workshop::engine::spawn(spawn_operation* operation)
+{
+  assert(operation);
+
+  if (!loader_.active() && !loader_.start(loader_workers)) {
+    // no worker threads so the object is created right away and the coroutine is not suspended
+    finish_spawn(operation);
+    return false;
+  }
+
+  operation->request_.paths.push_back(irrlicht_media_path() + mesh_files[operation->type_]);
+  // baked textures and textures of objects created earlier are not read again
+  irr::io::IFileSystem* fs = device_->getFileSystem();
+  for (const char* file : object_texture_files[operation->type_]) {
+    if (!file) continue;
+    const std::string texture = irrlicht_media_path() + file;
+    if (textures_.contains(texture) || runtime_.driver->findTexture(fs->getAbsolutePath(texture.c_str()))) continue;
+    operation->request_.paths.push_back(texture);
+  }
+  spawning_.push_back(operation);
+  loader_.submit(&operation->request_);
+  return true;
+}
+
+void workshop::engine::finish_spawn(spawn_operation* operation)
+{
+  assert(operation);
+  assert(device_);
+  assert(runtime_.smgr);
+  assert(runtime_.driver);
+
+  trace_scope scope("engine::finish_spawn", operation->name_);
+
+  // files read in the background go to the mesh and texture caches, textures first so that the mesh loaders find the
+  // ones they reference, meshes are named as resource_set() requests them and the driver names textures by their
+  // absolute paths
+  irr::io::IFileSystem* fs = device_->getFileSystem();
+  load_request& request = operation->request_;
+  for (std::size_t i = request.contents.size(); i-- > 0;) {
+    std::vector<char>& content = request.contents[i];
+    if (content.empty()) continue;
+    const irr::io::path path(request.paths[i].c_str());
+    const irr::io::path name = i == 0 ? path : fs->getAbsolutePath(path);
+    irr::io::IReadFile* file =
+      fs->createMemoryReadFile(content.data(), static_cast<irr::s32>(content.size()), name, false);
+    if (!file) continue;
+    if (i == 0)
+      runtime_.smgr->getMesh(file);
+    else
+      runtime_.driver->getTexture(file);
+    file->drop();
+  }
+  request.contents.clear();
+
+  object_handle* object = new (std::nothrow) object_handle(operation->type_, &operation->name_);
+  if (!object) return;
+  if (!object->resource_set(this) || !object->resource_) {
+    delete object;
+    return;
+  }
+
+  workshop::selector s;
+  if (s.init(this, object) != SELECTOR_INIT_SUCCESS) {
+    destroy_object(object);
+    return;
+  }
+  object->selector(&s);
+  operation->object_ = object;
+}
+
+void workshop::engine::destroy_object(object_handle* object)
+{
+  assert(object);
+  assert(object->resource_);
+
+  if (selected_object_ && selected_object_->resource_ == object->resource_) selected_object_ = nullptr;
+  collision_.remove(object->resource_);
+  render_queue_.remove(object->resource_);
+  object->resource_->remove();
+  delete object;
+}
+
+void workshop::engine::complete_spawns()
+{
+  for (int i = 0; i < max_spawns_per_frame; ++i) {
+    load_request* request = loader_.completed();
+    if (!request) return;
+    spawn_operation* operation = static_cast<spawn_operation*>(request->user_data);
+    spawning_.erase(std::find(spawning_.begin(), spawning_.end(), operation));
+
+    // the creation is the hitch of the frame, the resumed coroutine is the caller's work
+    const std::chrono::steady_clock::time_point spawn_begin = std::chrono::steady_clock::now();
+    finish_spawn(operation);
+    stats_.phase_ms[frame_stats::phase_spawn] += milliseconds(std::chrono::steady_clock::now() - spawn_begin);
+    ++stats_.spawns;
+    operation->continuation_.resume();
+  }
+}
+
+void workshop::engine::abandon_spawns()
+{
+  // workers finish the files they are reading, the operations are completed without objects
+  if (loader_.active()) loader_.stop();
+  while (!spawning_.empty()) {
+    spawn_operation* operation = spawning_.back();
+    spawning_.pop_back();
+    operation->object_ = nullptr;
+    operation->continuation_.resume();
+  }
+}
+
 bool workshop::engine::add_laser()
 {
   assert(laser_ == nullptr);
 
+  trace_scope scope("engine::add_laser");
+
   // add the laser
   if (!runtime_.smgr) {
     assert(device_);
@@ -326,7 +624,8 @@ bool workshop::engine::add_laser()
     runtime_.driver = device_->getVideoDriver();
   }
 
-  irr::video::ITexture* laser_tex = runtime_.driver->getTexture((irrlicht_media_path() + "/particle.bmp").c_str());
+  irr::video::ITexture* laser_tex =
+    load_texture(runtime_.driver, textures_, irrlicht_media_path() + laser_texture_file);
   if (!laser_tex) {
     laser_ = nullptr;
     return false;
@@ -339,45 +638,63 @@ bool workshop::engine::add_laser()
   laser_->setMaterialFlag(irr::video::EMF_ZBUFFER, false);
   laser_->setSize(irr::core::dimension2d<irr::f32>(20.0f, 20.0f));
   laser_->setID(id_flag_not_pickable);  // this ensures that we don't accidentally ray-pick it
+  render_queue_.add(laser_);
 
   return true;
 }
 
-int workshop::engine::add_level(irr::scene::IMeshSceneNode** level)
+int workshop::engine::add_level(irr::scene::IMeshSceneNode** level, baked_selector::data* baked)
 {
   assert(level);
   assert(runtime_.smgr);
 
+  trace_scope scope("engine::add_level");
+
   // get mesh
-  irr::scene::IAnimatedMesh* q3_level_mesh = runtime_.smgr->getMesh("20kdm2.bsp");
+  irr::scene::IAnimatedMesh* q3_level_mesh = load_mesh(runtime_.smgr, "20kdm2.bsp");
   if (!q3_level_mesh) return 1;
 
   // add node resource
-  irr::scene::IMeshSceneNode* q3_node =
-    runtime_.smgr->addOctreeSceneNode(q3_level_mesh->getMesh(0), nullptr, id_flag_is_pickable);
+  irr::scene::IMeshSceneNode* q3_node = nullptr;
+  {
+    trace_scope node_scope("addOctreeSceneNode");
+    q3_node = runtime_.smgr->addOctreeSceneNode(q3_level_mesh->getMesh(0), nullptr, id_flag_is_pickable);
+  }
   if (!q3_node) return 2;
   q3_node->setPosition(irr::core::vector3df(-1350, -130, -1400));
 
-  // assign triangle selector
-  irr::scene::ITriangleSelector* selector =
-    runtime_.smgr->createOctreeTriangleSelector(q3_node->getMesh(), q3_node, 128);
+  // assign triangle selector, baked from the mesh unless restored from a snapshot
+  baked_selector::data mesh_triangles;
+  if (!baked) {
+    trace_scope selector_scope("baked_selector::bake");
+    baked_selector::bake(q3_node->getMesh(), &mesh_triangles);
+    baked = &mesh_triangles;
+  }
+  irr::scene::ITriangleSelector* selector = new (std::nothrow) baked_selector(q3_node, std::move(*baked));
   if (!selector) {
     return 3;
   }
   q3_node->setTriangleSelector(selector);
+  add_selector(selector);
   selector->drop();
+  render_queue_.add(q3_node);
+  level_ = q3_node;
 
   *level = q3_node;
 
   return 0;
 }
 
-int workshop::engine::create_camera(camera** c)
+int workshop::engine::create_camera(camera** c) { return create_camera(c, nullptr); }
+
+int workshop::engine::create_camera(camera** c, baked_selector::data* level)
 {
   if (camera_ == nullptr) {
     // create camera
     assert(c);
 
+    trace_scope scope("engine::create_camera");
+
     camera_ = new (std::nothrow) camera;
     if (!camera_) return 1;
 
@@ -386,16 +703,22 @@ int workshop::engine::create_camera(camera** c)
       runtime_.smgr = device_->getSceneManager();
     }
 
-    irr::scene::IMeshSceneNode* level = nullptr;
-    if (add_level(&level)) {
+    irr::scene::IMeshSceneNode* level_node = nullptr;
+    if (add_level(&level_node, level)) {
       destroy_camera();
       return 2;
     }
 
-    if (camera_->init(runtime_.smgr, level)) {
+    if (camera_->init(runtime_.smgr)) {
       destroy_camera();
       return 3;
     }
+
+    collision_.level(level_node->getTriangleSelector());
+    if (!collision_.add(camera_->resource_, camera_radius, camera_gravity, camera_translation)) {
+      destroy_camera();
+      return 4;
+    }
   }
 
   assert(camera_);
@@ -411,6 +734,334 @@ void workshop::engine::destroy_camera()
   camera_ = nullptr;
 }
 
+bool workshop::engine::add_collider(object_handle* object)
+{
+  assert(object);
+  assert(object->resource_);
+  assert(camera_);
+
+  // fit the ellipsoid into the current bounding box of the character
+  object->resource_->updateAbsolutePosition();
+  const irr::core::aabbox3df box = object->resource_->getTransformedBoundingBox();
+  const irr::core::vector3df radius = box.getExtent() / 2.f;
+  const irr::core::vector3df translation = object->resource_->getAbsolutePosition() - box.getCenter();
+  if (!collision_.add(object->resource_, radius, irr::core::vector3df(0, 0, 0), translation)) return false;
+  if (std::find(colliders_.begin(), colliders_.end(), object) == colliders_.end()) colliders_.push_back(object);
+  return true;
+}
+
+void workshop::engine::track(object_handle* object)
+{
+  assert(object);
+  assert(object->resource_);
+  assert(object->engine_ == nullptr);
+
+  object->resource_->updateAbsolutePosition();
+  object->proxy_ = objects_.insert(object->resource_->getTransformedBoundingBox(), object);
+  object->engine_ = this;
+  if (object->selector_) add_selector(object->selector_);
+}
+
+void workshop::engine::untrack(object_handle* object)
+{
+  assert(object);
+
+  // copies of a tracked object share its proxy but are not tracked themselves
+  if (objects_.user_data(object->proxy_) != object) return;
+
+  objects_.remove(object->proxy_);
+  colliders_.erase(std::remove(colliders_.begin(), colliders_.end(), object), colliders_.end());
+  if (object->selector_) remove_selector(object->selector_);
+  object->proxy_ = aabb_tree::null_node;
+  object->engine_ = nullptr;
+}
+
+void workshop::engine::add_selector(const irr::scene::ITriangleSelector* selector)
+{
+  assert(selector);
+
+  ++selectors_;
+  selector_triangles_ += static_cast<irr::u32>(selector->getTriangleCount());
+}
+
+void workshop::engine::remove_selector(const irr::scene::ITriangleSelector* selector)
+{
+  assert(selector);
+  assert(selectors_ > 0);
+
+  --selectors_;
+  selector_triangles_ -= static_cast<irr::u32>(selector->getTriangleCount());
+}
+
+void workshop::engine::refit(object_handle* object)
+{
+  assert(object);
+
+  if (objects_.user_data(object->proxy_) != object) return;
+
+  object->resource_->updateAbsolutePosition();
+  objects_.move(object->proxy_, object->resource_->getTransformedBoundingBox());
+}
+
+std::size_t workshop::engine::query_sphere(const irr::core::vector3df& center, irr::f32 radius, object_handle** out,
+                                           std::size_t capacity) const
+{
+  assert(out || capacity == 0);
+
+  // all matches are counted so that the caller can tell a truncated result and retry with a larger buffer
+  std::size_t count = 0;
+  objects_.query([&](const irr::core::aabbox3df& box) { return box_intersects_sphere(box, center, radius); },
+                 [&](void* user_data) {
+                   object_handle* object = static_cast<object_handle*>(user_data);
+                   if (box_intersects_sphere(object->resource_->getTransformedBoundingBox(), center, radius)) {
+                     if (count < capacity) out[count] = object;
+                     ++count;
+                   }
+                   return true;
+                 });
+  return count;
+}
+
+std::size_t workshop::engine::query_box(const irr::core::aabbox3df& box, object_handle** out,
+                                        std::size_t capacity) const
+{
+  assert(out || capacity == 0);
+
+  std::size_t count = 0;
+  objects_.query([&](const irr::core::aabbox3df& b) { return box_intersects_box(b, box); },
+                 [&](void* user_data) {
+                   object_handle* object = static_cast<object_handle*>(user_data);
+                   if (box_intersects_box(object->resource_->getTransformedBoundingBox(), box)) {
+                     if (count < capacity) out[count] = object;
+                     ++count;
+                   }
+                   return true;
+                 });
+  return count;
+}
+
+std::size_t workshop::engine::query_frustum(const irr::scene::SViewFrustum& frustum, object_handle** out,
+                                            std::size_t capacity) const
+{
+  assert(out || capacity == 0);
+
+  std::size_t count = 0;
+  objects_.query([&](const irr::core::aabbox3df& box) { return box_intersects_frustum(box, frustum); },
+                 [&](void* user_data) {
+                   object_handle* object = static_cast<object_handle*>(user_data);
+                   if (box_intersects_frustum(object->resource_->getTransformedBoundingBox(), frustum)) {
+                     if (count < capacity) out[count] = object;
+                     ++count;
+                   }
+                   return true;
+                 });
+  return count;
+}
+
+bool workshop::engine::save_snapshot(const std::string& path) const
+{
+  trace_scope scope("engine::save_snapshot", path);
+
+  scene_snapshot snapshot;
+  snapshot.camera = camera_ != nullptr;
+  if (camera_) {
+    snapshot.camera_position = camera_->resource_->getPosition();
+    snapshot.camera_target = camera_->resource_->getTarget();
+  }
+  snapshot.laser = laser_ != nullptr;
+  snapshot.laser_visible = laser_ && laser_->isVisible();
+  if (laser_) snapshot.laser_position = laser_->getPosition();
+
+  // the level selector is always baked by add_level()
+  if (level_) snapshot.level = static_cast<const baked_selector*>(level_->getTriangleSelector())->baked();
+
+  objects_.query([](const irr::core::aabbox3df&) { return true; },
+                 [&](void* user_data) {
+                   const object_handle* object = static_cast<object_handle*>(user_data);
+                   const irr::scene::IAnimatedMeshSceneNode* node = object->resource_;
+                   scene_snapshot::object& o = snapshot.objects.emplace_back();
+                   o.type = object->type_;
+                   o.name = node->getName();
+                   o.position = node->getPosition();
+                   o.rotation = node->getRotation();
+                   o.frame = node->getFrameNr();
+                   o.selector = object->selector_ != nullptr;
+                   o.collider = std::find(colliders_.begin(), colliders_.end(), object) != colliders_.end();
+                   o.selector_frame = object->selector_ ? object->selector_->frame() : 0.f;
+                   if (object->selector_) o.triangles = object->selector_->triangles();
+                   return true;
+                 });
+
+  return snapshot.save(path);
+}
+
+bool workshop::engine::load_snapshot(const std::string& path, std::vector<object_handle*>* objects)
+{
+  assert(objects);
+  assert(laser_ || !"laser has to be added before the snapshot is loaded");
+
+  trace_scope scope("engine::load_snapshot", path);
+
+  scene_snapshot snapshot;
+  if (!snapshot.load(path)) return false;
+
+  if (snapshot.camera) {
+    camera* c = nullptr;
+    if (create_camera(&c, &snapshot.level)) return false;
+    c->resource_->setPosition(snapshot.camera_position);
+    c->resource_->setTarget(snapshot.camera_target);
+  }
+
+  // objects of the same type share meshes and textures loaded once by the first of them
+  std::stable_sort(snapshot.objects.begin(), snapshot.objects.end(),
+                   [](const scene_snapshot::object& lhs, const scene_snapshot::object& rhs) {
+                     return lhs.type < rhs.type;
+                   });
+  objects->reserve(objects->size() + snapshot.objects.size());
+  for (scene_snapshot::object& o : snapshot.objects) {
+    if (o.type < 0 || o.type >= object_handle::type_num) return false;
+    object_handle* object = new (std::nothrow) object_handle(static_cast<object_handle::type>(o.type), &o.name);
+    if (!object) return false;
+    if (!object->resource_set(this) || !object->resource_) {
+      delete object;
+      return false;
+    }
+    objects->push_back(object);
+
+    object->resource_->setPosition(o.position);
+    object->resource_->setRotation(o.rotation);
+    object->resource_->setCurrentFrame(o.frame);
+    refit(object);
+    if (o.selector) {
+      workshop::selector s;
+      if (s.init(this, object, std::move(o.triangles), o.selector_frame) != SELECTOR_INIT_SUCCESS) return false;
+      object->selector(&s);
+    }
+    if (o.collider && camera_ && !add_collider(object)) return false;
+  }
+
+  laser_->setVisible(snapshot.laser && snapshot.laser_visible);
+  laser_->setPosition(snapshot.laser_position);
+  return true;
+}
+
+workshop::memory_counters::data workshop::engine::memory_report() const
+{
+  // estimates are reported for this engine only and are not stored in the process-wide registry
+  memory_counters::data report = memory_counters::instance().get();
+  auto estimate = [&](int subsystem, std::size_t bytes) { report[subsystem] = {bytes, bytes}; };
+
+  std::size_t meshes = 0;
+  if (runtime_.smgr) {
+    irr::scene::IMeshCache* cache = runtime_.smgr->getMeshCache();
+    for (irr::u32 i = 0; i < cache->getMeshCount(); ++i) meshes += mesh_memory(cache->getMeshByIndex(i));
+  }
+  estimate(memory_counters::mesh_cache, meshes);
+
+  // font bitmaps are loaded as textures so they are excluded from the textures count
+  std::size_t fonts = 0;
+  const irr::gui::IGUISpriteBank* font_bank = nullptr;
+  if (font_ && font_->getType() == irr::gui::EGFT_BITMAP) {
+    font_bank = static_cast<irr::gui::IGUIFontBitmap*>(font_)->getSpriteBank();
+    for (irr::u32 i = 0; font_bank && i < font_bank->getTextureCount(); ++i)
+      if (font_bank->getTexture(i)) fonts += texture_memory(font_bank->getTexture(i));
+  }
+  estimate(memory_counters::fonts, fonts);
+
+  std::size_t textures = 0;
+  if (runtime_.driver) {
+    for (irr::u32 i = 0; i < runtime_.driver->getTextureCount(); ++i) {
+      irr::video::ITexture* texture = runtime_.driver->getTextureByIndex(i);
+      if (texture) textures += texture_memory(texture);
+    }
+  }
+  estimate(memory_counters::textures, textures > fonts ? textures - fonts : 0);
+
+  return report;
+}
+
+bool workshop::engine::stress_test(const stress_config& config, stress_report* report)
+{
+  assert(report);
+  assert(device_);
+  assert(camera_);
+  assert(laser_);
+  assert(config.sweep_frames > 0);
+
+  trace_scope scope("engine::stress_test");
+
+  // the camera follows the sweep instead of the collision resolver
+  irr::scene::ICameraSceneNode* cam = camera_->resource_;
+  const irr::core::vector3df position = cam->getPosition();
+  const irr::core::vector3df target = cam->getTarget();
+  collision_.remove(cam);
+
+  // objects fill a disc around the camera (Vogel spiral) so every step has objects in all directions
+  auto create = [&](object_handle::type t, std::size_t index) -> object_handle* {
+    const std::string name = type_names[t];
+    object_handle* object = new (std::nothrow) object_handle(t, &name);
+    if (!object) return nullptr;
+    if (!object->resource_set(this) || !object->resource_) {
+      delete object;
+      return nullptr;
+    }
+    workshop::selector s;
+    if (s.init(this, object) != SELECTOR_INIT_SUCCESS) {
+      destroy_object(object);
+      return nullptr;
+    }
+    object->selector(&s);
+    const irr::f32 angle = 2.39996f * static_cast<irr::f32>(index);
+    const irr::f32 distance = 60.f + 15.f * std::sqrt(static_cast<irr::f32>(index));
+    object->position(position.X + distance * std::cos(angle), position.Y - 60.f,
+                     position.Z + distance * std::sin(angle));
+    return object;
+  };
+
+  report->steps.clear();
+  std::vector<object_handle*> objects;
+  bool result = true;
+  for (int t = 0; result && t < object_handle::type_num; ++t) {
+    for (std::size_t i = 0; result && i < config.counts.size(); ++i) {
+      while (result && objects.size() < config.counts[i]) {
+        object_handle* object = create(static_cast<object_handle::type>(t), objects.size());
+        if (object)
+          objects.push_back(object);
+        else
+          result = false;
+      }
+      if (!result) break;
+
+      // the first frame after spawning is not measured
+      stress_report::step step{type_names[t], objects.size(), 0.f, 0.f, 0.f, 0};
+      const float sweep_frames = static_cast<float>(config.sweep_frames);
+      for (unsigned frame = 0; result && frame <= config.sweep_frames; ++frame) {
+        const irr::f32 angle = 2.f * irr::core::PI * static_cast<irr::f32>(frame) / sweep_frames;
+        cam->setPosition(position);
+        cam->setTarget(position + irr::core::vector3df(std::cos(angle), -0.3f, std::sin(angle)) * 100.f);
+        result = run() && begin_scene() && end_scene();
+        if (frame == 0 || !result) continue;
+        const frame_stats& stats = stats_history_.last();
+        step.frame_ms += stats.frame_ms / sweep_frames;
+        step.max_frame_ms = std::max(step.max_frame_ms, stats.frame_ms);
+        step.picking_ms += stats.phase_ms[frame_stats::phase_picking] / sweep_frames;
+      }
+      if (!result) break;
+
+      for (const memory_counters::usage& usage : memory_report()) step.memory += usage.current;
+      report->steps.push_back(step);
+    }
+
+    for (object_handle* object : objects) destroy_object(object);
+    objects.clear();
+  }
+
+  cam->setPosition(position);
+  cam->setTarget(target);
+  if (!collision_.add(cam, camera_radius, camera_gravity, camera_translation)) return false;
+  return result;
+}
+
 int workshop::engine::add_light()
 {
   // add a light, so that the unselected nodes aren't completely dark.
@@ -435,7 +1086,17 @@ workshop::engine::engine(const std::string& irrlicht_media_path, device_type* ty
     font_(nullptr),
     laser_(nullptr),
     camera_(nullptr),
-    selected_object_(nullptr)
+    selected_object_(nullptr),
+    objects_(spatial_index_margin),
+    level_(nullptr),
+    stats_{},
+    selectors_(0),
+    selector_triangles_(0),
+    texture_count_(0),
+    texture_memory_(0),
+    stats_overlay_(false),
+    log_time_(0),
+    log_restart_(false)
 {
   if (type) {
     device_type_ = *type;
@@ -446,6 +1107,19 @@ workshop::engine::engine(const std::string& irrlicht_media_path, device_type* ty
 
 workshop::engine::~engine()
 {
+  // awaiting coroutines are resumed while the device is alive so that their frames are cleaned up
+  abandon_spawns();
+
+  // objects may outlive the engine
+  objects_.query([](const irr::core::aabbox3df&) { return true; },
+                 [](void* user_data) {
+                   object_handle* object = static_cast<object_handle*>(user_data);
+                   object->engine_ = nullptr;
+                   object->proxy_ = aabb_tree::null_node;
+                   return true;
+                 });
+  // the capture render target belongs to the driver
+  if (capture_.active()) capture_.stop();
   if (device_) device_->drop();
   if (event_receiver_) delete event_receiver_;
 }
@@ -455,8 +1129,8 @@ void workshop::engine::draw_label(const std::string& label)
   assert(font_);
   assert(runtime_.driver);
 
-  font_->draw(
-    std::wstring(label.begin(), label.end()).c_str(),
+  render_queue_.add_label(
+    std::wstring(label.begin(), label.end()),
     irr::core::rect<irr::s32>(100, 10, static_cast<irr::s32>(runtime_.driver->getScreenSize().Width - 100), 60),
     irr::video::SColor(0xff, 0xff, 0xff, 0xf0), true, true);
 }
@@ -473,9 +1147,34 @@ int workshop::engine::process_collisions()
 
   irr::core::vector3df intersection;    // tracks the current intersection point with the level or a mesh
   irr::core::triangle3df hit_triangle;  // used to show which triangle has been hit
+  irr::scene::ISceneNode* selected_scene_node = nullptr;
+  ++stats_.picking_rays;
+
+  // the level shortens the ray so characters behind walls are culled by the spatial index
   irr::scene::ISceneCollisionManager* coll_man = runtime_.smgr->getSceneCollisionManager();
-  irr::scene::ISceneNode* selected_scene_node =
-    coll_man->getSceneNodeAndCollisionPointFromRay(ray, intersection, hit_triangle, id_flag_is_pickable);
+  if (level_ && level_->getTriangleSelector()) {
+    ++stats_.picking_tests;
+    irr::scene::ISceneNode* node = nullptr;
+    if (coll_man->getCollisionPoint(ray, level_->getTriangleSelector(), intersection, hit_triangle, node)) {
+      ray.end = intersection;
+      selected_scene_node = level_;
+    }
+  }
+
+  // only characters whose boxes are crossed by the ray refit their triangles to the current animation frame
+  objects_.query([&](const irr::core::aabbox3df& box) { return box.intersectsWithLine(ray); },
+                 [&](void* user_data) {
+                   const object_handle* object = static_cast<object_handle*>(user_data);
+                   irr::scene::IAnimatedMeshSceneNode* node = object->resource_;
+                   if (!object->selector_ || node->getTriangleSelector() != object->selector_) return true;
+                   if (!node->isVisible() || (node->getID() & id_flag_is_pickable) == 0) return true;
+                   ++stats_.picking_tests;
+                   if (object->selector_->intersect(ray, &intersection, &hit_triangle)) {
+                     ray.end = intersection;
+                     selected_scene_node = node;
+                   }
+                   return true;
+                 });
   if (selected_scene_node) {
     // show laser and move it to position of detected collision with other node
     assert(laser_);
@@ -523,15 +1222,86 @@ bool workshop::engine::begin_scene()
   assert(runtime_.guienv);
   assert(font_);
 
+  using clock = std::chrono::steady_clock;
+  clock::time_point phase_begin = clock::now();
+  if (frame_end_ == clock::time_point()) frame_end_ = phase_begin;
+  auto phase_end = [&](frame_stats::phase p) {
+    const clock::time_point now = clock::now();
+    stats_.phase_ms[p] = milliseconds(now - phase_begin);
+    phase_begin = now;
+  };
+
+  // logged frames replay recorded input and advance the scene time by a fixed step
+  if (input_log_.state() == input_log::mode_replay) {
+    if (input_log_.read_frame(&replay_events_, &replay_position_, &replay_target_)) {
+      for (const irr::SEvent& event : replay_events_) device_->postEventFromUser(event);
+    } else {
+      stop_input_log();
+      event_receiver_->quit_ = true;
+    }
+  }
+  if (input_log_.state() != input_log::mode_off) {
+    log_time_ += input_log_.step_ms();
+    device_->getTimer()->setTime(log_time_);
+  }
+
   if (!runtime_.driver->beginScene()) return false;
+  if (capture_.active()) capture_.begin(runtime_.driver);
+  if (scaler_.enabled()) scaler_.begin(runtime_.driver);
+
+  // animations run before the collision response and picking, drawAll() repeats them with no time elapsed
+  runtime_.smgr->getRootSceneNode()->OnAnimate(device_->getTimer()->getTime());
+  if (log_restart_) {
+    // animations of the first logged frame depend on the real time elapsed since they were started
+    objects_.query([](const irr::core::aabbox3df&) { return true; },
+                   [](void* user_data) {
+                     irr::scene::IAnimatedMeshSceneNode* node = static_cast<object_handle*>(user_data)->resource_;
+                     node->setCurrentFrame(static_cast<irr::f32>(node->getStartFrame()));
+                     return true;
+                   });
+    log_restart_ = false;
+  }
+  phase_end(frame_stats::phase_scene);
 
+  // resolve movement against the level
+  assert(event_receiver_);
+  if (event_receiver_->jump_) {
+    if (camera_) collision_.jump(camera_->resource_, 2.f);
+    event_receiver_->jump_ = false;
+  }
+  collision_.update(device_->getTimer()->getTime());
+  // animation changes the boxes of all objects, not only of the moved ones, and picking culls by them
+  objects_.refit([](void* user_data) {
+    irr::scene::IAnimatedMeshSceneNode* node = static_cast<object_handle*>(user_data)->resource_;
+    node->updateAbsolutePosition();
+    return node->getTransformedBoundingBox();
+  });
+  if (camera_ && input_log_.state() == input_log::mode_replay) {
+    camera_->resource_->setPosition(replay_position_);
+    camera_->resource_->setTarget(replay_target_);
+    camera_->resource_->updateAbsolutePosition();
+  }
+  if (input_log_.state() == input_log::mode_record) {
+    const irr::core::vector3df position = camera_ ? camera_->resource_->getPosition() : irr::core::vector3df();
+    const irr::core::vector3df target = camera_ ? camera_->resource_->getTarget() : irr::core::vector3df();
+    if (!input_log_.write_frame(position, target)) stop_input_log();
+  }
+  phase_end(frame_stats::phase_collision);
+
+  if (process_collisions() < 0) return false;
+  phase_end(frame_stats::phase_picking);
+
+  // scene manager sets up camera and lights and draws the render queue in its passes
   runtime_.smgr->drawAll();
+  if (scaler_.enabled()) scaler_.resolve(runtime_.driver, capture_.target());
+  phase_end(frame_stats::phase_render);
+
   runtime_.guienv->drawAll();
   const irr::s32 top = static_cast<irr::s32>(runtime_.driver->getScreenSize().Height - 50);
   const irr::s32 bottom = static_cast<irr::s32>(runtime_.driver->getScreenSize().Height);
-  font_->draw(L"Press 'q' to exit", irr::core::rect<irr::s32>(10, top, 200, bottom),
-              irr::video::SColor(0xff, 0xff, 0xff, 0xf0), false, true);
-  if (process_collisions() < 0) return false;
+  render_queue_.add_label(L"Press 'q' to exit", irr::core::rect<irr::s32>(10, top, 200, bottom),
+                          irr::video::SColor(0xff, 0xff, 0xff, 0xf0), false, true);
+  phase_end(frame_stats::phase_gui);
 
   return true;
 }
@@ -540,7 +1310,171 @@ bool workshop::engine::end_scene()
 {
   assert(runtime_.driver);
 
-  return runtime_.driver->endScene();
+  const std::chrono::steady_clock::time_point present_begin = std::chrono::steady_clock::now();
+  if (stats_overlay_) draw_stats();
+  render_queue_.submit_labels(font_);
+  if (capture_.active()) capture_.capture(runtime_.driver);
+  const bool result = runtime_.driver->endScene();
+  stats_.phase_ms[frame_stats::phase_present] = milliseconds(std::chrono::steady_clock::now() - present_begin);
+
+  complete_spawns();
+  sample_stats();
+  return result;
+}
+
+bool workshop::engine::enable_dynamic_resolution(float budget_ms, float min_scale)
+{
+  assert(runtime_.driver);
+
+  if (scaler_.enabled()) return false;
+  return scaler_.enable(runtime_.driver, budget_ms, min_scale);
+}
+
+void workshop::engine::disable_dynamic_resolution()
+{
+  assert(runtime_.driver);
+
+  if (scaler_.enabled()) scaler_.disable(runtime_.driver);
+}
+
+bool workshop::engine::start_recording(const std::string& path, irr::u32 step_ms)
+{
+  assert(event_receiver_);
+
+  if (input_log_.state() != input_log::mode_off || !input_log_.record(path, step_ms)) return false;
+  event_receiver_->log_ = &input_log_;
+  start_input_log();
+  return true;
+}
+
+bool workshop::engine::start_replay(const std::string& path)
+{
+  if (input_log_.state() != input_log::mode_off || !input_log_.replay(path)) return false;
+
+  // camera is driven by the log instead of the user
+  if (camera_) camera_->resource_->setInputReceiverEnabled(false);
+  start_input_log();
+  return true;
+}
+
+void workshop::engine::start_input_log()
+{
+  assert(device_);
+
+  irr::ITimer* timer = device_->getTimer();
+  timer->stop();
+  log_time_ = timer->getTime();
+  log_restart_ = true;
+}
+
+void workshop::engine::stop_input_log()
+{
+  assert(device_);
+  assert(event_receiver_);
+
+  if (input_log_.state() == input_log::mode_off) return;
+  if (input_log_.state() == input_log::mode_replay && camera_) camera_->resource_->setInputReceiverEnabled(true);
+  input_log_.close();
+  event_receiver_->log_ = nullptr;
+  device_->getTimer()->start();
+}
+
+bool workshop::engine::start_capture(const std::string& path, frame_capture::format f, irr::u32 fps,
+                                     std::size_t buffers)
+{
+  assert(runtime_.driver);
+
+  if (capture_.active()) return false;
+  const irr::core::dimension2d<irr::u32> size = runtime_.driver->getScreenSize();
+  return capture_.start(runtime_.driver, path, f, size.Width, size.Height, fps, buffers);
+}
+
+void workshop::engine::stop_capture()
+{
+  if (capture_.active()) capture_.stop();
+}
+
+void workshop::engine::sample_stats()
+{
+  assert(runtime_.driver);
+
+  irr::video::IVideoDriver* driver = runtime_.driver;
+  stats_.fps = driver->getFPS();
+  stats_.primitives = driver->getPrimitiveCountDrawn();
+
+  const render_queue::statistics& queue = render_queue_.stats();
+  stats_.nodes_rendered = queue.nodes;
+  stats_.nodes_culled = queue.culled;
+  stats_.draws = queue.items;
+  stats_.material_changes = queue.material_changes;
+
+  // textures are also loaded implicitly by meshes and fonts so their memory is summed again only when the set grows
+  // or shrinks, or when render targets were recreated for a new window size
+  if (driver->getTextureCount() != texture_count_ || driver->getScreenSize() != texture_screen_) {
+    texture_count_ = driver->getTextureCount();
+    texture_screen_ = driver->getScreenSize();
+    texture_memory_ = 0;
+    for (irr::u32 i = 0; i < texture_count_; ++i) {
+      irr::video::ITexture* texture = driver->getTextureByIndex(i);
+      if (texture) texture_memory_ += texture_memory(texture);
+    }
+  }
+  stats_.textures = texture_count_;
+  stats_.texture_memory = texture_memory_;
+
+  // selectors are counted when they are attached to the level and tracked objects
+  stats_.selectors = selectors_;
+  stats_.selector_triangles = selector_triangles_;
+
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  stats_.frame_ms = milliseconds(now - frame_end_);
+  frame_end_ = now;
+
+  stats_.resolution_scale = scaler_.scale();
+
+  // time outside of begin_scene() and end_scene() and time spent spawning objects do not depend on the resolution
+  float work_ms = 0.f;
+  for (int p = 0; p < frame_stats::phase_spawn; ++p) work_ms += stats_.phase_ms[p];
+  scaler_.update(work_ms);
+
+  stats_history_.push(stats_);
+  const irr::u32 frame = stats_.frame;
+  stats_ = frame_stats{};
+  stats_.frame = frame + 1;
+}
+
+void workshop::engine::draw_stats()
+{
+  assert(runtime_.driver);
+
+  if (stats_history_.empty()) return;
+  const frame_stats& s = stats_history_.last();
+
+  char lines[4][160];
+  std::snprintf(lines[0], sizeof(lines[0]), "FPS %d  frame %.2f ms  average %.2f ms  max %.2f ms  scale %.2f", s.fps,
+                s.frame_ms, stats_history_.average_frame_ms(), stats_history_.max_frame_ms(), s.resolution_scale);
+  std::snprintf(lines[1], sizeof(lines[1]), "primitives %u  nodes %u drawn %u culled  draws %u  materials %u",
+                s.primitives, s.nodes_rendered, s.nodes_culled, s.draws, s.material_changes);
+  std::snprintf(lines[2], sizeof(lines[2]), "textures %u (%.1f MB)  selectors %u (%u triangles)  picking %u tests",
+                s.textures, static_cast<double>(s.texture_memory) / (1024 * 1024), s.selectors, s.selector_triangles,
+                s.picking_tests);
+  std::string phases;
+  for (int p = 0; p < frame_stats::phase_num; ++p) {
+    char phase[32];
+    std::snprintf(phase, sizeof(phase), "%s %.2f  ", frame_stats::name(static_cast<frame_stats::phase>(p)),
+                  s.phase_ms[p]);
+    phases += phase;
+  }
+  std::snprintf(lines[3], sizeof(lines[3]), "%sms", phases.c_str());
+
+  const irr::s32 width = static_cast<irr::s32>(runtime_.driver->getScreenSize().Width);
+  irr::s32 top = 70;
+  for (const char* line : lines) {
+    const std::string text(line);
+    render_queue_.add_label(std::wstring(text.begin(), text.end()), irr::core::rect<irr::s32>(10, top, width, top + 20),
+                            irr::video::SColor(0xff, 0xff, 0xff, 0xf0), false, true);
+    top += 20;
+  }
 }
 
 void workshop::engine::yield()
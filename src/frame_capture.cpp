@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/frame_capture.h>
+#include <cassert>
+#include <cstring>
+#include <system_error>
+
+namespace {
+
+irr::u8 clamp_byte(int value) { return static_cast<irr::u8>(value < 0 ? 0 : value > 255 ? 255 : value); }
+
+irr::u8 expand5(unsigned value) { return static_cast<irr::u8>((value << 3) | (value >> 2)); }
+irr::u8 expand6(unsigned value) { return static_cast<irr::u8>((value << 2) | (value >> 4)); }
+
+// converts locked render target pixels to RGB24, returns false for formats render targets do not use
+bool to_rgb24(const irr::u8* src, irr::video::ECOLOR_FORMAT format, irr::u32 pitch, irr::u32 width, irr::u32 height,
+              irr::u8* dst)
+{
+  auto convert = [&](std::size_t pixel_size, auto pixel) {
+    for (irr::u32 y = 0; y < height; ++y) {
+      const irr::u8* p = src + static_cast<std::size_t>(y) * pitch;
+      for (irr::u32 x = 0; x < width; ++x, p += pixel_size, dst += 3) pixel(p, dst);
+    }
+    return true;
+  };
+
+  switch (format) {
+    case irr::video::ECF_A8R8G8B8:
+      return convert(4, [](const irr::u8* p, irr::u8* rgb) {
+        irr::u32 c;
+        std::memcpy(&c, p, sizeof(c));
+        rgb[0] = static_cast<irr::u8>(c >> 16);
+        rgb[1] = static_cast<irr::u8>(c >> 8);
+        rgb[2] = static_cast<irr::u8>(c);
+      });
+    case irr::video::ECF_R8G8B8:
+      return convert(3, [](const irr::u8* p, irr::u8* rgb) { std::memcpy(rgb, p, 3); });
+    case irr::video::ECF_A1R5G5B5:
+      return convert(2, [](const irr::u8* p, irr::u8* rgb) {
+        irr::u16 c;
+        std::memcpy(&c, p, sizeof(c));
+        rgb[0] = expand5((c >> 10) & 0x1f);
+        rgb[1] = expand5((c >> 5) & 0x1f);
+        rgb[2] = expand5(c & 0x1f);
+      });
+    case irr::video::ECF_R5G6B5:
+      return convert(2, [](const irr::u8* p, irr::u8* rgb) {
+        irr::u16 c;
+        std::memcpy(&c, p, sizeof(c));
+        rgb[0] = expand5((c >> 11) & 0x1f);
+        rgb[1] = expand6((c >> 5) & 0x3f);
+        rgb[2] = expand5(c & 0x1f);
+      });
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+/* ********************************* F R A M E   C A P T U R E ********************************* */
+
+workshop::frame_capture::frame_capture() :
+    driver_(nullptr), target_(nullptr), file_(nullptr), format_(format_raw), width_(0), height_(0), stats_{},
+    stopping_(false)
+{
+}
+
+workshop::frame_capture::~frame_capture()
+{
+  if (active()) stop();
+}
+
+bool workshop::frame_capture::start(irr::video::IVideoDriver* driver, const std::string& path, format f,
+                                    irr::u32 width, irr::u32 height, irr::u32 fps, std::size_t buffers)
+{
+  assert(driver);
+  assert(!active());
+  assert(width > 0 && height > 0);
+  assert(fps > 0);
+  assert(buffers > 0);
+
+  if (!driver->queryFeature(irr::video::EVDF_RENDER_TO_TARGET)) return false;
+  target_ = driver->addRenderTargetTexture(irr::core::dimension2d<irr::u32>(width, height), "frame-capture");
+  if (!target_) return false;
+  driver_ = driver;
+
+  file_ = std::fopen(path.c_str(), "wb");
+  if (!file_ ||
+      (f == format_y4m && std::fprintf(file_, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", width, height, fps) < 0)) {
+    if (file_) std::fclose(file_);
+    file_ = nullptr;
+    driver_->removeTexture(target_);
+    target_ = nullptr;
+    return false;
+  }
+
+  format_ = f;
+  width_ = width;
+  height_ = height;
+  stats_ = statistics{};
+  stopping_ = false;
+
+  frames_.resize(buffers);
+  for (frame& fr : frames_) {
+    fr.pixels.resize(static_cast<std::size_t>(width) * height * 3);
+    free_.push_back(&fr);
+  }
+
+  try {
+    writer_ = std::thread(&frame_capture::run, this);
+  } catch (const std::system_error&) {
+    std::fclose(file_);
+    file_ = nullptr;
+    free_.clear();
+    frames_.clear();
+    driver_->removeTexture(target_);
+    target_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void workshop::frame_capture::stop()
+{
+  assert(active());
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  ready_.notify_one();
+  writer_.join();
+
+  std::fclose(file_);
+  file_ = nullptr;
+  free_.clear();
+  frames_.clear();
+  yuv_.clear();
+  driver_->removeTexture(target_);
+  target_ = nullptr;
+}
+
+void workshop::frame_capture::begin(irr::video::IVideoDriver* driver)
+{
+  assert(driver);
+  assert(active());
+
+  driver->setRenderTarget(target_, true, true, irr::video::SColor(0));
+}
+
+void workshop::frame_capture::capture(irr::video::IVideoDriver* driver)
+{
+  assert(driver);
+  assert(active());
+
+  frame* f = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) {
+      ++stats_.dropped;
+    } else {
+      f = free_.back();
+      free_.pop_back();
+    }
+  }
+
+  if (f) {
+    // the only copy of the frame converts the render target straight into the pooled buffer
+    bool captured = false;
+    const void* pixels = target_->lock(irr::video::ETLM_READ_ONLY);
+    if (pixels) {
+      captured = to_rgb24(static_cast<const irr::u8*>(pixels), target_->getColorFormat(), target_->getPitch(), width_,
+                          height_, f->pixels.data());
+      target_->unlock();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (captured) {
+        queue_.push_back(f);
+        ++stats_.captured;
+      } else {
+        free_.push_back(f);
+        ++stats_.dropped;
+      }
+    }
+    if (captured) ready_.notify_one();
+  }
+
+  // frame buffer was cleared by beginScene()
+  driver->setRenderTarget(nullptr, false, false);
+  driver->draw2DImage(target_, irr::core::position2d<irr::s32>(0, 0));
+}
+
+workshop::frame_capture::statistics workshop::frame_capture::stats() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void workshop::frame_capture::run()
+{
+  for (;;) {
+    frame* f = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) return;
+      f = queue_.front();
+      queue_.pop_front();
+    }
+
+    const bool written = write(*f);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(f);
+    if (written)
+      ++stats_.written;
+    else
+      ++stats_.failed;
+  }
+}
+
+bool workshop::frame_capture::write(const frame& f)
+{
+  switch (format_) {
+    case format_raw:
+      return std::fwrite(f.pixels.data(), 1, f.pixels.size(), file_) == f.pixels.size();
+
+    case format_ppm:
+      if (std::fprintf(file_, "P6\n%u %u\n255\n", width_, height_) < 0) return false;
+      return std::fwrite(f.pixels.data(), 1, f.pixels.size(), file_) == f.pixels.size();
+
+    case format_y4m: {
+      // full range BT.601 with chroma averaged over 2x2 pixel blocks
+      const irr::u32 chroma_width = (width_ + 1) / 2;
+      const irr::u32 chroma_height = (height_ + 1) / 2;
+      const std::size_t luma_size = static_cast<std::size_t>(width_) * height_;
+      const std::size_t chroma_size = static_cast<std::size_t>(chroma_width) * chroma_height;
+      yuv_.resize(luma_size + 2 * chroma_size);
+      irr::u8* y_plane = yuv_.data();
+      irr::u8* u_plane = y_plane + luma_size;
+      irr::u8* v_plane = u_plane + chroma_size;
+
+      for (irr::u32 y = 0; y < height_; ++y) {
+        const irr::u8* rgb = f.pixels.data() + static_cast<std::size_t>(y) * width_ * 3;
+        for (irr::u32 x = 0; x < width_; ++x, rgb += 3)
+          y_plane[static_cast<std::size_t>(y) * width_ + x] =
+            clamp_byte((77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2] + 128) >> 8);
+      }
+
+      for (irr::u32 cy = 0; cy < chroma_height; ++cy) {
+        for (irr::u32 cx = 0; cx < chroma_width; ++cx) {
+          int r = 0, g = 0, b = 0, n = 0;
+          for (irr::u32 y = cy * 2; y < cy * 2 + 2 && y < height_; ++y) {
+            for (irr::u32 x = cx * 2; x < cx * 2 + 2 && x < width_; ++x) {
+              const irr::u8* rgb = f.pixels.data() + (static_cast<std::size_t>(y) * width_ + x) * 3;
+              r += rgb[0];
+              g += rgb[1];
+              b += rgb[2];
+              ++n;
+            }
+          }
+          r /= n;
+          g /= n;
+          b /= n;
+          const std::size_t i = static_cast<std::size_t>(cy) * chroma_width + cx;
+          u_plane[i] = clamp_byte(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128);
+          v_plane[i] = clamp_byte(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128);
+        }
+      }
+
+      if (std::fputs("FRAME\n", file_) < 0) return false;
+      return std::fwrite(yuv_.data(), 1, yuv_.size(), file_) == yuv_.size();
+    }
+  }
+  return false;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/frame_stats.h>
+#include <algorithm>
+#include <cassert>
+
+/* ********************************* F R A M E   S T A T S ********************************* */
+
+const char* workshop::frame_stats::name(phase p)
+{
+  const char* names[] = {"scene", "collision", "picking", "render", "gui", "present", "spawn"};
+  static_assert(sizeof(names) / sizeof(names[0]) == phase_num);
+  assert(0 <= p && p < phase_num);
+  return names[p];
+}
+
+/* ********************************* F R A M E   H I S T O R Y ********************************* */
+
+workshop::frame_history::frame_history() : frames_{}, next_(0), size_(0) {}
+
+void workshop::frame_history::push(const frame_stats& stats)
+{
+  frames_[next_] = stats;
+  next_ = (next_ + 1) % capacity;
+  size_ = std::min(size_ + 1, capacity);
+}
+
+const workshop::frame_stats& workshop::frame_history::operator[](std::size_t age) const
+{
+  assert(age < size_);
+
+  return frames_[(next_ + capacity - 1 - age) % capacity];
+}
+
+float workshop::frame_history::average_frame_ms() const
+{
+  if (size_ == 0) return 0.f;
+
+  float sum = 0.f;
+  for (std::size_t i = 0; i < size_; ++i) sum += (*this)[i].frame_ms;
+  return sum / static_cast<float>(size_);
+}
+
+float workshop::frame_history::max_frame_ms() const
+{
+  float result = 0.f;
+  for (std::size_t i = 0; i < size_; ++i) result = std::max(result, (*this)[i].frame_ms);
+  return result;
+}
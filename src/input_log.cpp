@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/input_log.h>
+#include <cassert>
+#include <cstring>
+
+namespace {
+
+enum record_type : irr::u8 { record_key = 1, record_mouse, record_frame };
+
+const char magic[4] = {'I', 'R', 'L', 'G'};
+
+template<typename T>
+bool put(std::FILE* file, const T& value) { return std::fwrite(&value, sizeof(value), 1, file) == 1; }
+
+template<typename T>
+bool get(std::FILE* file, T* value) { return std::fread(value, sizeof(*value), 1, file) == 1; }
+
+bool put(std::FILE* file, const irr::core::vector3df& v) { return put(file, v.X) && put(file, v.Y) && put(file, v.Z); }
+
+bool get(std::FILE* file, irr::core::vector3df* v) { return get(file, &v->X) && get(file, &v->Y) && get(file, &v->Z); }
+
+}  // namespace
+
+/* ********************************* I N P U T   L O G ********************************* */
+
+workshop::input_log::input_log() : file_(nullptr), mode_(mode_off), step_ms_(0), failed_(false) {}
+
+workshop::input_log::~input_log()
+{
+  if (file_) close();
+}
+
+bool workshop::input_log::record(const std::string& path, irr::u32 step_ms)
+{
+  assert(mode_ == mode_off);
+  assert(step_ms > 0);
+
+  failed_ = false;
+  file_ = std::fopen(path.c_str(), "wb");
+  if (!file_) return false;
+
+  if (std::fwrite(magic, sizeof(magic), 1, file_) != 1 || !put(file_, version) || !put(file_, step_ms)) {
+    close();
+    return false;
+  }
+
+  mode_ = mode_record;
+  step_ms_ = step_ms;
+  return true;
+}
+
+bool workshop::input_log::replay(const std::string& path)
+{
+  assert(mode_ == mode_off);
+
+  file_ = std::fopen(path.c_str(), "rb");
+  if (!file_) return false;
+
+  char file_magic[sizeof(magic)];
+  irr::u32 file_version = 0;
+  irr::u32 step_ms = 0;
+  if (std::fread(file_magic, sizeof(file_magic), 1, file_) != 1 || std::memcmp(file_magic, magic, sizeof(magic)) ||
+      !get(file_, &file_version) || file_version != version || !get(file_, &step_ms) || step_ms == 0) {
+    close();
+    return false;
+  }
+
+  mode_ = mode_replay;
+  step_ms_ = step_ms;
+  return true;
+}
+
+bool workshop::input_log::close()
+{
+  assert(file_);
+
+  // closing flushes buffered records so it fails like any other write
+  const bool closed = std::fclose(file_) == 0;
+  if (mode_ == mode_record && !closed) failed_ = true;
+  file_ = nullptr;
+  mode_ = mode_off;
+  return closed;
+}
+
+bool workshop::input_log::write_event(const irr::SEvent& event)
+{
+  assert(mode_ == mode_record);
+
+  if (failed_) return false;
+  bool written = true;
+  switch (event.EventType) {
+    case irr::EET_KEY_INPUT_EVENT: {
+      const irr::SEvent::SKeyInput& key = event.KeyInput;
+      const irr::u8 flags = static_cast<irr::u8>(key.PressedDown | key.Shift << 1 | key.Control << 2);
+      written = put(file_, record_key) && put(file_, static_cast<irr::u32>(key.Char)) &&
+                put(file_, static_cast<irr::u32>(key.Key)) && put(file_, flags);
+    } break;
+
+    case irr::EET_MOUSE_INPUT_EVENT: {
+      const irr::SEvent::SMouseInput& mouse = event.MouseInput;
+      const irr::u8 flags = static_cast<irr::u8>(mouse.Shift | mouse.Control << 1);
+      written = put(file_, record_mouse) && put(file_, mouse.X) && put(file_, mouse.Y) && put(file_, mouse.Wheel) &&
+                put(file_, mouse.ButtonStates) && put(file_, static_cast<irr::u8>(mouse.Event)) && put(file_, flags);
+    } break;
+
+    default:
+      // GUI and other events are generated by the engine itself
+      break;
+  }
+  if (!written) failed_ = true;
+  return written;
+}
+
+bool workshop::input_log::write_frame(const irr::core::vector3df& position, const irr::core::vector3df& target)
+{
+  assert(mode_ == mode_record);
+
+  if (failed_) return false;
+  if (!put(file_, record_frame) || !put(file_, position) || !put(file_, target)) failed_ = true;
+  return !failed_;
+}
+
+bool workshop::input_log::read_frame(std::vector<irr::SEvent>* events, irr::core::vector3df* position,
+                                     irr::core::vector3df* target)
+{
+  assert(mode_ == mode_replay);
+  assert(events);
+  assert(position);
+  assert(target);
+
+  events->clear();
+  for (;;) {
+    irr::u8 type = 0;
+    if (!get(file_, &type)) return false;
+
+    irr::SEvent event;
+    std::memset(&event, 0, sizeof(event));
+    irr::u8 flags = 0;
+    switch (type) {
+      case record_key: {
+        irr::u32 character = 0;
+        irr::u32 key = 0;
+        if (!get(file_, &character) || !get(file_, &key) || !get(file_, &flags)) return false;
+        event.EventType = irr::EET_KEY_INPUT_EVENT;
+        event.KeyInput.Char = static_cast<wchar_t>(character);
+        event.KeyInput.Key = static_cast<irr::EKEY_CODE>(key);
+        event.KeyInput.PressedDown = flags & 1;
+        event.KeyInput.Shift = flags & 2;
+        event.KeyInput.Control = flags & 4;
+        events->push_back(event);
+      } break;
+
+      case record_mouse: {
+        irr::u8 mouse_event = 0;
+        event.EventType = irr::EET_MOUSE_INPUT_EVENT;
+        if (!get(file_, &event.MouseInput.X) || !get(file_, &event.MouseInput.Y) ||
+            !get(file_, &event.MouseInput.Wheel) || !get(file_, &event.MouseInput.ButtonStates) ||
+            !get(file_, &mouse_event) || !get(file_, &flags))
+          return false;
+        event.MouseInput.Event = static_cast<irr::EMOUSE_INPUT_EVENT>(mouse_event);
+        event.MouseInput.Shift = flags & 1;
+        event.MouseInput.Control = flags & 2;
+        events->push_back(event);
+      } break;
+
+      case record_frame:
+        return get(file_, position) && get(file_, target);
+
+      default:
+        return false;
+    }
+  }
+}
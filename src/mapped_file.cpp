@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/mapped_file.h>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* ********************************* M A P P E D   F I L E ********************************* */
+
+#ifdef _WIN32
+
+workshop::mapped_file::mapped_file(const std::string& path) : data_(nullptr), size_(0)
+{
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return;
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+    // the view keeps the mapping alive after both handles are closed
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+      data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      if (data_) size_ = static_cast<std::size_t>(size.QuadPart);
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+}
+
+workshop::mapped_file::~mapped_file()
+{
+  if (data_) UnmapViewOfFile(data_);
+}
+
+#else
+
+workshop::mapped_file::mapped_file(const std::string& path) : data_(nullptr), size_(0)
+{
+  const int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) return;
+  struct stat info;
+  if (fstat(file, &info) == 0 && info.st_size > 0) {
+    // the mapping stays valid after the descriptor is closed
+    void* view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    if (view != MAP_FAILED) {
+      data_ = static_cast<const char*>(view);
+      size_ = static_cast<std::size_t>(info.st_size);
+    }
+  }
+  close(file);
+}
+
+workshop::mapped_file::~mapped_file()
+{
+  if (data_) munmap(const_cast<char*>(data_), size_);
+}
+
+#endif
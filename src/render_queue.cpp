@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/render_queue.h>
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <new>
+#include <utility>
+
+/* ********************************* R E N D E R   Q U E U E   N O D E ********************************* */
+
+/**
+ * Scene node drawing the queue in the render passes of the scene manager
+ *
+ * Children are animated by the scene manager as usual, but they are handed to the queue instead of being registered
+ * for rendering.
+ */
+class workshop::render_queue::scene_node : public irr::scene::ISceneNode {
+public:
+  scene_node(render_queue* queue, irr::scene::ISceneManager* smgr) :
+      irr::scene::ISceneNode(smgr->getRootSceneNode(), smgr), queue_(queue)
+  {
+    setAutomaticCulling(irr::scene::EAC_OFF);
+  }
+
+  void OnRegisterSceneNode() override
+  {
+    if (!IsVisible) return;
+
+    queue_->visible_.clear();
+    for (irr::scene::ISceneNode* child : Children) {
+      if (!child->isVisible()) continue;
+      queue_->visible_.push_back(child);
+
+      // nodes attached to the queued ones are still drawn by the scene manager
+      for (irr::scene::ISceneNode* attached : child->getChildren()) attached->OnRegisterSceneNode();
+    }
+
+    SceneManager->registerNodeForRendering(this, irr::scene::ESNRP_SOLID);
+    SceneManager->registerNodeForRendering(this, irr::scene::ESNRP_TRANSPARENT);
+  }
+
+  void render() override
+  {
+    irr::video::IVideoDriver* driver = SceneManager->getVideoDriver();
+    if (SceneManager->getSceneNodeRenderPass() == irr::scene::ESNRP_SOLID) {
+      queue_->prepare(SceneManager);
+      queue_->submit(driver, pass_solid);
+    } else
+      queue_->submit(driver, pass_transparent);
+  }
+
+  const irr::core::aabbox3df& getBoundingBox() const override { return box_; }
+
+private:
+  render_queue* queue_;       /// drawn queue
+  irr::core::aabbox3df box_;  /// empty box, the node is never culled
+};
+
+/* ********************************* R E N D E R   Q U E U E ********************************* */
+
+workshop::render_queue::render_queue() : node_(nullptr), stats_{} {}
+
+void workshop::render_queue::add(irr::scene::ISceneNode* node)
+{
+  assert(node);
+  assert(std::find(nodes_.begin(), nodes_.end(), node) == nodes_.end());
+
+  nodes_.push_back(node);
+
+  if (!node_) {
+    // the scene manager keeps the node alive
+    node_ = new (std::nothrow) scene_node(this, node->getSceneManager());
+    if (!node_) return;
+    node_->drop();
+  }
+  node->setParent(node_);
+}
+
+void workshop::render_queue::remove(irr::scene::ISceneNode* node)
+{
+  assert(node);
+
+  nodes_.erase(std::remove(nodes_.begin(), nodes_.end(), node), nodes_.end());
+  visible_.erase(std::remove(visible_.begin(), visible_.end(), node), visible_.end());
+  if (node_ && node->getParent() == node_) node->setParent(node_->getParent());
+}
+
+void workshop::render_queue::collect(irr::scene::ISceneNode* node, const irr::core::vector3df& camera_position)
+{
+  const irr::f32 distance = camera_position.getDistanceFromSQ(node->getAbsolutePosition());
+
+  // nodes draw themselves, once in every pass they have materials for, and are sorted by their first material;
+  // animated meshes are shared through the mesh cache and animated in place, so the pose of a node is only valid
+  // while that node renders it
+  const irr::video::SMaterial* pass_material[2] = {nullptr, nullptr};
+  for (irr::u32 i = 0; i < node->getMaterialCount(); ++i) {
+    const irr::video::SMaterial& material = node->getMaterial(i);
+    const render_pass pass = material.isTransparent() ? pass_transparent : pass_solid;
+    if (!pass_material[pass]) pass_material[pass] = &material;
+  }
+  for (const render_pass pass : {pass_solid, pass_transparent}) {
+    const irr::video::SMaterial* material = pass_material[pass];
+    if (!material) continue;
+    items_.push_back({pass, material->MaterialType, material->getTexture(0), material->Lighting, distance, node});
+  }
+}
+
+void workshop::render_queue::prepare(irr::scene::ISceneManager* smgr)
+{
+  assert(smgr);
+
+  stats_ = statistics{};
+  items_.clear();
+
+  const irr::scene::ICameraSceneNode* camera = smgr->getActiveCamera();
+  const irr::core::vector3df camera_position = camera ? camera->getAbsolutePosition() : irr::core::vector3df();
+  for (irr::scene::ISceneNode* node : visible_) {
+    if (smgr->isCulled(node)) {
+      ++stats_.culled;
+      continue;
+    }
+    ++stats_.nodes;
+    collect(node, camera_position);
+  }
+
+  // solid draws are grouped by state, transparent draws go back to front
+  std::sort(items_.begin(), items_.end(), [](const item& lhs, const item& rhs) {
+    if (lhs.pass != rhs.pass) return lhs.pass < rhs.pass;
+    if (lhs.pass == pass_transparent) return lhs.distance > rhs.distance;
+    if (lhs.type != rhs.type) return lhs.type < rhs.type;
+    if (lhs.texture != rhs.texture) return std::less<const irr::video::ITexture*>()(lhs.texture, rhs.texture);
+    if (lhs.lighting != rhs.lighting) return lhs.lighting < rhs.lighting;
+    return std::less<const irr::scene::ISceneNode*>()(lhs.node, rhs.node);
+  });
+}
+
+void workshop::render_queue::submit(irr::video::IVideoDriver* driver, render_pass pass)
+{
+  assert(driver);
+
+  // the driver skips redundant state itself, the queue only makes equal materials follow each other
+  const item* last = nullptr;
+  for (const item& i : items_) {
+    if (i.pass != pass) continue;
+    ++stats_.items;
+
+    if (!last || last->type != i.type || last->texture != i.texture || last->lighting != i.lighting)
+      ++stats_.material_changes;
+    else
+      ++stats_.material_elided;
+    last = &i;
+
+    i.node->render();
+  }
+}
+
+void workshop::render_queue::add_label(std::wstring text, const irr::core::rect<irr::s32>& position,
+                                       irr::video::SColor color, bool hcenter, bool vcenter)
+{
+  labels_.push_back({std::move(text), position, color, hcenter, vcenter});
+}
+
+void workshop::render_queue::submit_labels(irr::gui::IGUIFont* font)
+{
+  assert(labels_.empty() || font);
+
+  for (const label& l : labels_) font->draw(l.text.c_str(), l.position, l.color, l.hcenter, l.vcenter);
+  labels_.clear();
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/resolution_scaler.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const float smoothing = 0.1f;   // weight of the last frame in the smoothed frame time
+const float max_step = 0.05f;   // largest scale change per frame
+const float dead_zone = 0.05f;  // relative frame time error that does not change the scale
+
+}  // namespace
+
+/* ********************************* R E S O L U T I O N   S C A L E R ********************************* */
+
+workshop::resolution_scaler::resolution_scaler() :
+    target_(nullptr), output_(nullptr), cpu_(false), budget_ms_(0.f), min_scale_(1.f), scale_(1.f), average_ms_(0.f)
+{
+}
+
+bool workshop::resolution_scaler::enable(irr::video::IVideoDriver* driver, float budget_ms, float min_scale)
+{
+  assert(driver);
+  assert(!enabled());
+  assert(budget_ms > 0.f);
+  assert(0.f < min_scale && min_scale <= 1.f);
+
+  if (!driver->queryFeature(irr::video::EVDF_RENDER_TO_TARGET)) return false;
+
+  // the software driver draws 2D images unscaled only
+  cpu_ = driver->getDriverType() == irr::video::EDT_SOFTWARE;
+  if (!create(driver, driver->getScreenSize())) return false;
+
+  budget_ms_ = budget_ms;
+  min_scale_ = min_scale;
+  scale_ = 1.f;
+  average_ms_ = budget_ms;
+  return true;
+}
+
+void workshop::resolution_scaler::disable(irr::video::IVideoDriver* driver)
+{
+  assert(driver);
+  assert(enabled());
+
+  release(driver);
+  scale_ = 1.f;
+}
+
+bool workshop::resolution_scaler::create(irr::video::IVideoDriver* driver,
+                                         const irr::core::dimension2d<irr::u32>& size)
+{
+  assert(target_ == nullptr);
+  assert(output_ == nullptr);
+
+  size_ = size;
+  target_ = driver->addRenderTargetTexture(size_, "dynamic-resolution");
+  if (!target_) return false;
+  if (!cpu_) return true;
+
+  output_ = driver->addTexture(size_, "dynamic-resolution-output", target_->getColorFormat());
+  if (output_) return true;
+
+  release(driver);
+  return false;
+}
+
+void workshop::resolution_scaler::release(irr::video::IVideoDriver* driver)
+{
+  if (output_) driver->removeTexture(output_);
+  if (target_) driver->removeTexture(target_);
+  output_ = nullptr;
+  target_ = nullptr;
+}
+
+irr::core::rect<irr::s32> workshop::resolution_scaler::viewport() const
+{
+  return irr::core::rect<irr::s32>(0, 0, std::max(1, static_cast<irr::s32>(static_cast<float>(size_.Width) * scale_)),
+                                   std::max(1, static_cast<irr::s32>(static_cast<float>(size_.Height) * scale_)));
+}
+
+void workshop::resolution_scaler::begin(irr::video::IVideoDriver* driver)
+{
+  assert(driver);
+  assert(enabled());
+
+  if (driver->getScreenSize() != size_) {
+    release(driver);
+    if (!create(driver, driver->getScreenSize())) return;
+  }
+
+  driver->setRenderTarget(target_, true, true, irr::video::SColor(0));
+  driver->setViewPort(viewport());
+}
+
+bool workshop::resolution_scaler::upscale()
+{
+  const irr::u8* source = static_cast<const irr::u8*>(target_->lock(irr::video::ETLM_READ_ONLY));
+  if (!source) return false;
+  irr::u8* destination = static_cast<irr::u8*>(output_->lock(irr::video::ETLM_WRITE_ONLY));
+  if (!destination) {
+    target_->unlock();
+    return false;
+  }
+
+  // nearest neighbour, both textures share the color format
+  const irr::u32 pixel_size = irr::video::IImage::getBitsPerPixelFromFormat(target_->getColorFormat()) / 8;
+  const irr::core::rect<irr::s32> source_rect = viewport();
+  const irr::u32 source_width = static_cast<irr::u32>(source_rect.getWidth());
+  const irr::u32 source_height = static_cast<irr::u32>(source_rect.getHeight());
+  columns_.resize(size_.Width);
+  for (irr::u32 x = 0; x < size_.Width; ++x) columns_[x] = x * source_width / size_.Width * pixel_size;
+
+  for (irr::u32 y = 0; y < size_.Height; ++y) {
+    const std::size_t source_y = y * source_height / size_.Height;
+    const irr::u8* source_row = source + source_y * target_->getPitch();
+    irr::u8* destination_row = destination + static_cast<std::size_t>(y) * output_->getPitch();
+    for (irr::u32 x = 0; x < size_.Width; ++x)
+      std::memcpy(destination_row + static_cast<std::size_t>(x) * pixel_size, source_row + columns_[x], pixel_size);
+  }
+
+  output_->unlock();
+  target_->unlock();
+  return true;
+}
+
+void workshop::resolution_scaler::resolve(irr::video::IVideoDriver* driver, irr::video::ITexture* output)
+{
+  assert(driver);
+  assert(enabled());
+
+  // output was cleared by beginScene() or when it was made the render target
+  driver->setRenderTarget(output, false, false);
+  if (cpu_) {
+    if (upscale()) driver->draw2DImage(output_, irr::core::position2d<irr::s32>(0, 0));
+    return;
+  }
+
+  const irr::core::dimension2d<irr::u32> output_size = output ? output->getOriginalSize() : size_;
+  driver->draw2DImage(target_,
+                      irr::core::rect<irr::s32>(0, 0, static_cast<irr::s32>(output_size.Width),
+                                                static_cast<irr::s32>(output_size.Height)),
+                      viewport());
+}
+
+void workshop::resolution_scaler::update(float frame_ms)
+{
+  if (!enabled()) return;
+
+  average_ms_ += smoothing * (frame_ms - average_ms_);
+  if (std::fabs(average_ms_ - budget_ms_) <= dead_zone * budget_ms_) return;
+
+  const float target = scale_ * std::sqrt(budget_ms_ / std::max(average_ms_, 0.001f));
+  scale_ = std::clamp(std::clamp(target, scale_ - max_step, scale_ + max_step), min_scale_, 1.f);
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <irrlicht-engine/snapshot.h>
+#include <irrlicht-engine/mapped_file.h>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+const char magic[8] = {'I', 'R', 'R', 'S', 'N', 'A', 'P', '\0'};
+
+enum { flag_selector = 1 << 0, flag_collider = 1 << 1 };
+enum { flag_camera = 1 << 0, flag_laser = 1 << 1, flag_laser_visible = 1 << 2 };
+
+struct vector_record {
+  irr::f32 x, y, z;
+};
+
+struct header_record {
+  char magic[8];
+  irr::u32 version;
+  irr::u32 flags;
+  irr::u32 object_count;
+  irr::u32 objects_offset;
+  irr::u32 cluster_count;
+  irr::u32 clusters_offset;
+  irr::u32 triangle_count;
+  irr::u32 triangles_offset;
+  irr::u32 level_triangle_count;
+  irr::u32 names_offset;
+  irr::u32 names_size;
+  vector_record camera_position;
+  vector_record camera_target;
+  vector_record laser_position;
+};
+
+struct object_record {
+  irr::s32 type;
+  irr::u32 name_offset;
+  irr::u32 name_size;
+  vector_record position;
+  vector_record rotation;
+  irr::f32 frame;
+  irr::u32 flags;
+  irr::f32 selector_frame;
+  irr::u32 first_triangle;
+  irr::u32 triangle_count;
+};
+
+static_assert(std::is_trivially_copyable_v<header_record> && sizeof(header_record) % 4 == 0);
+static_assert(std::is_trivially_copyable_v<object_record> && sizeof(object_record) % 4 == 0);
+
+// triangles and clusters are written as they are laid out in memory
+static_assert(std::is_standard_layout_v<irr::core::triangle3df> &&
+              sizeof(irr::core::triangle3df) == 9 * sizeof(irr::f32));
+static_assert(std::is_standard_layout_v<workshop::baked_selector::cluster> &&
+              sizeof(workshop::baked_selector::cluster) == 8 * 4);
+
+vector_record to_record(const irr::core::vector3df& v) { return {v.X, v.Y, v.Z}; }
+
+irr::core::vector3df from_record(const vector_record& v) { return irr::core::vector3df(v.x, v.y, v.z); }
+
+template<typename T>
+bool write_array(std::FILE* file, const T* data, std::size_t count)
+{
+  return count == 0 || std::fwrite(data, sizeof(T), count, file) == count;
+}
+
+template<typename Container>
+void read_array(const char* data, std::size_t count, Container* out)
+{
+  out->resize(count);
+  if (count) std::memcpy(static_cast<void*>(out->data()), data, count * sizeof(typename Container::value_type));
+}
+
+// checks that an array of count elements of the given size at offset lies inside the file
+bool in_file(std::size_t file_size, irr::u32 offset, irr::u32 count, std::size_t element_size)
+{
+  return offset <= file_size && count <= (file_size - offset) / element_size;
+}
+
+}  // namespace
+
+/* ********************************* S N A P S H O T ********************************* */
+
+bool workshop::scene_snapshot::save(const std::string& path) const
+{
+  // triangles of the level come first, objects refer to their own ranges behind them
+  std::vector<object_record> records;
+  std::string names;
+  irr::u32 triangle_count = static_cast<irr::u32>(level.triangles.size());
+  records.reserve(objects.size());
+  for (const object& o : objects) {
+    const irr::u32 flags = (o.selector ? flag_selector : 0) | (o.collider ? flag_collider : 0);
+    const irr::u32 object_triangles = o.selector ? static_cast<irr::u32>(o.triangles.size()) : 0;
+    records.push_back({o.type, static_cast<irr::u32>(names.size()), static_cast<irr::u32>(o.name.size()),
+                       to_record(o.position), to_record(o.rotation), o.frame, flags, o.selector_frame,
+                       triangle_count, object_triangles});
+    names += o.name;
+    triangle_count += object_triangles;
+  }
+
+  header_record header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.flags = (camera ? flag_camera : 0) | (laser ? flag_laser : 0) | (laser_visible ? flag_laser_visible : 0);
+  header.object_count = static_cast<irr::u32>(records.size());
+  header.objects_offset = sizeof(header_record);
+  header.cluster_count = static_cast<irr::u32>(level.clusters.size());
+  header.clusters_offset = static_cast<irr::u32>(header.objects_offset + records.size() * sizeof(object_record));
+  header.triangle_count = triangle_count;
+  header.triangles_offset =
+    static_cast<irr::u32>(header.clusters_offset + level.clusters.size() * sizeof(baked_selector::cluster));
+  header.level_triangle_count = static_cast<irr::u32>(level.triangles.size());
+  header.names_offset =
+    static_cast<irr::u32>(header.triangles_offset + triangle_count * sizeof(irr::core::triangle3df));
+  header.names_size = static_cast<irr::u32>(names.size());
+  header.camera_position = to_record(camera_position);
+  header.camera_target = to_record(camera_target);
+  header.laser_position = to_record(laser_position);
+
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) return false;
+  bool written = write_array(file, &header, 1) && write_array(file, records.data(), records.size()) &&
+                 write_array(file, level.clusters.data(), level.clusters.size()) &&
+                 write_array(file, level.triangles.data(), level.triangles.size());
+  for (const object& o : objects)
+    if (written && o.selector) written = write_array(file, o.triangles.data(), o.triangles.size());
+  if (written) written = write_array(file, names.data(), names.size());
+  return std::fclose(file) == 0 && written;
+}
+
+bool workshop::scene_snapshot::load(const std::string& path)
+{
+  // records are copied straight out of the mapped file
+  const mapped_file file(path);
+  const char* data = file.data();
+  const std::size_t size = file.size();
+  if (!data) return false;
+
+  header_record header;
+  if (size < sizeof(header)) return false;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, magic, sizeof(magic)) || header.version != version) return false;
+  if (!in_file(size, header.objects_offset, header.object_count, sizeof(object_record)) ||
+      !in_file(size, header.clusters_offset, header.cluster_count, sizeof(baked_selector::cluster)) ||
+      !in_file(size, header.triangles_offset, header.triangle_count, sizeof(irr::core::triangle3df)) ||
+      !in_file(size, header.names_offset, header.names_size, 1) ||
+      header.level_triangle_count > header.triangle_count)
+    return false;
+
+  camera = (header.flags & flag_camera) != 0;
+  camera_position = from_record(header.camera_position);
+  camera_target = from_record(header.camera_target);
+  laser = (header.flags & flag_laser) != 0;
+  laser_visible = (header.flags & flag_laser_visible) != 0;
+  laser_position = from_record(header.laser_position);
+
+  const char* triangles = data + header.triangles_offset;
+  read_array(data + header.clusters_offset, header.cluster_count, &level.clusters);
+  read_array(triangles, header.level_triangle_count, &level.triangles);
+  for (const baked_selector::cluster& c : level.clusters)
+    if (c.first > header.level_triangle_count || c.count > header.level_triangle_count - c.first) return false;
+
+  const char* names = data + header.names_offset;
+  objects.clear();
+  objects.reserve(header.object_count);
+  for (irr::u32 i = 0; i < header.object_count; ++i) {
+    object_record record;
+    std::memcpy(&record, data + header.objects_offset + i * sizeof(object_record), sizeof(record));
+    if (record.name_offset > header.names_size || record.name_size > header.names_size - record.name_offset ||
+        record.first_triangle > header.triangle_count ||
+        record.triangle_count > header.triangle_count - record.first_triangle)
+      return false;
+    object& o = objects.emplace_back();
+    o.type = record.type;
+    o.name.assign(names + record.name_offset, record.name_size);
+    o.position = from_record(record.position);
+    o.rotation = from_record(record.rotation);
+    o.frame = record.frame;
+    o.selector = (record.flags & flag_selector) != 0;
+    o.collider = (record.flags & flag_collider) != 0;
+    o.selector_frame = record.selector_frame;
+    read_array(triangles + record.first_triangle * sizeof(irr::core::triangle3df), record.triangle_count,
+               &o.triangles);
+  }
+  return true;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/stress_test.h>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+/* ********************************* S T R E S S   T E S T ********************************* */
+
+void workshop::stress_report::print() const
+{
+  std::cout << "\nStress test:\n";
+  std::cout << "============\n";
+  std::cout << "   " << std::left << std::setw(8) << "Type" << std::right << std::setw(8) << "Objects" << std::setw(12)
+            << "Frame ms" << std::setw(12) << "Max ms" << std::setw(12) << "Picking ms" << std::setw(12) << "Memory KiB"
+            << std::setw(14) << "Frame growth" << std::setw(16) << "Picking growth" << "\n";
+
+  std::cout << std::fixed << std::setprecision(2);
+  for (std::size_t i = 0; i < steps.size(); ++i) {
+    const step& s = steps[i];
+    std::cout << "   " << std::left << std::setw(8) << s.type << std::right << std::setw(8) << s.objects
+              << std::setw(12) << s.frame_ms << std::setw(12) << s.max_frame_ms << std::setw(12) << s.picking_ms
+              << std::setw(12) << s.memory / 1024;
+
+    // growth is relative to the previous step with fewer objects of the same type
+    const step* previous = i > 0 ? &steps[i - 1] : nullptr;
+    if (previous && !std::strcmp(previous->type, s.type) && previous->objects && previous->objects < s.objects) {
+      const float count_ratio = static_cast<float>(s.objects) / static_cast<float>(previous->objects);
+      auto growth = [&](float before, float after) { return before > 0.f ? after / before / count_ratio : 0.f; };
+      std::cout << std::setw(14) << growth(previous->frame_ms, s.frame_ms) << std::setw(16)
+                << growth(previous->picking_ms, s.picking_ms);
+    }
+    std::cout << "\n";
+  }
+  std::cout.unsetf(std::ios::floatfield);
+  std::cout << std::setprecision(6);
+}
@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/texture_cache.h>
+#include <irrlicht-engine/mapped_file.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+const char magic[8] = {'I', 'R', 'R', 'T', 'E', 'X', 'C', '\0'};
+const irr::u32 pixels_alignment = 16;
+
+struct header_record {
+  char magic[8];
+  irr::u32 version;
+  irr::u32 driver;
+  irr::u32 texture_count;
+  irr::u32 textures_offset;
+  irr::u32 names_offset;
+  irr::u32 names_size;
+};
+
+struct texture_record {
+  irr::u32 name_offset;
+  irr::u32 name_size;
+  irr::u32 format;
+  irr::u32 width;
+  irr::u32 height;
+  irr::u32 levels;
+  irr::u32 pixels_offset;
+  irr::u32 pixels_size;
+};
+
+static_assert(std::is_trivially_copyable_v<header_record> && sizeof(header_record) % 4 == 0);
+static_assert(std::is_trivially_copyable_v<texture_record> && sizeof(texture_record) % 4 == 0);
+
+irr::u32 bytes_per_pixel(irr::video::ECOLOR_FORMAT format)
+{
+  return irr::video::IImage::getBitsPerPixelFromFormat(format) / 8;
+}
+
+irr::core::dimension2d<irr::u32> next_level(const irr::core::dimension2d<irr::u32>& size)
+{
+  return irr::core::dimension2d<irr::u32>(std::max(1u, size.Width / 2), std::max(1u, size.Height / 2));
+}
+
+// levels of a full mipmap chain down to 1x1 as expected by the drivers
+irr::u32 level_count(irr::core::dimension2d<irr::u32> size)
+{
+  irr::u32 levels = 1;
+  for (; size.Width > 1 || size.Height > 1; ++levels) size = next_level(size);
+  return levels;
+}
+
+std::size_t pixels_size(irr::video::ECOLOR_FORMAT format, irr::core::dimension2d<irr::u32> size, irr::u32 levels)
+{
+  std::size_t total = 0;
+  for (irr::u32 i = 0; i < levels; ++i, size = next_level(size))
+    total += static_cast<std::size_t>(size.Width) * size.Height * bytes_per_pixel(format);
+  return total;
+}
+
+std::size_t align(std::size_t offset) { return (offset + pixels_alignment - 1) / pixels_alignment * pixels_alignment; }
+
+}  // namespace
+
+/**
+ * Opened cache file
+ *
+ * Registered as an image loader so the driver keeps it alive as long as it may load images.
+ */
+class workshop::texture_cache::storage : public irr::video::IImageLoader {
+public:
+  mapped_file file;                     /// whole cache file mapped read-only
+  std::vector<texture_record> records;  /// texture records
+  std::vector<irr::io::path> names;     /// absolute texture names
+  irr::video::IVideoDriver* driver;     /// driver the textures were baked for
+  irr::io::IFileSystem* fs;             /// file system resolving names
+
+  storage(const std::string& path, irr::video::IVideoDriver* d, irr::io::IFileSystem* f) :
+      file(path), driver(d), fs(f)
+  {
+  }
+
+  // pixels are only read by the driver, the mapping itself is never written
+  char* pixels(const texture_record& r) const { return const_cast<char*>(file.data()) + r.pixels_offset; }
+
+  irr::io::path absolute(const std::string& name) const { return fs->getAbsolutePath(name.c_str()); }
+
+  int find(const irr::io::path& absolute_name) const
+  {
+    const auto it = std::find(names.begin(), names.end(), absolute_name);
+    return it == names.end() ? -1 : static_cast<int>(it - names.begin());
+  }
+
+  bool isALoadableFileExtension(const irr::io::path& filename) const override { return find(filename) >= 0; }
+
+  bool isALoadableFileFormat(irr::io::IReadFile*) const override { return false; }
+
+  irr::video::IImage* loadImage(irr::io::IReadFile* file) const override
+  {
+    const int index = find(file->getFileName());
+    if (index < 0) return nullptr;
+
+    // loaded images may be modified (e.g. by the font loader) so pixels are copied
+    const texture_record& r = records[index];
+    return driver->createImageFromData(static_cast<irr::video::ECOLOR_FORMAT>(r.format),
+                                       irr::core::dimension2d<irr::u32>(r.width, r.height),
+                                       pixels(r), false);
+  }
+};
+
+/* ********************************* T E X T U R E   C A C H E ********************************* */
+
+workshop::texture_cache::~texture_cache()
+{
+  if (storage_) storage_->drop();
+}
+
+bool workshop::texture_cache::open(const std::string& path, irr::video::IVideoDriver* driver, irr::io::IFileSystem* fs)
+{
+  assert(storage_ == nullptr);
+  assert(driver);
+  assert(fs);
+
+  // the file is mapped into memory and pixels are used in place
+  storage* s = new (std::nothrow) storage(path, driver, fs);
+  if (!s) return false;
+  const char* const data = s->file.data();
+  const std::size_t file_size = s->file.size();
+
+  auto parse = [&] {
+    header_record header;
+    if (!data || file_size < sizeof(header)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) || header.version != version ||
+        header.driver != static_cast<irr::u32>(driver->getDriverType()))
+      return false;
+    if (header.textures_offset > file_size ||
+        header.texture_count > (file_size - header.textures_offset) / sizeof(texture_record) ||
+        header.names_offset > file_size || header.names_size > file_size - header.names_offset)
+      return false;
+
+    s->records.resize(header.texture_count);
+    for (irr::u32 i = 0; i < header.texture_count; ++i) {
+      texture_record& r = s->records[i];
+      std::memcpy(&r, data + header.textures_offset + i * sizeof(texture_record), sizeof(r));
+      const auto format = static_cast<irr::video::ECOLOR_FORMAT>(r.format);
+      const irr::core::dimension2d<irr::u32> size(r.width, r.height);
+      if (r.name_offset > header.names_size || r.name_size > header.names_size - r.name_offset) return false;
+      if (r.pixels_offset % pixels_alignment || r.pixels_offset > file_size ||
+          r.pixels_size > file_size - r.pixels_offset)
+        return false;
+      if (!r.width || !r.height || !r.levels || r.levels > level_count(size) || !bytes_per_pixel(format) ||
+          r.pixels_size != pixels_size(format, size, r.levels))
+        return false;
+      s->names.push_back(s->absolute(std::string(data + header.names_offset + r.name_offset, r.name_size)));
+    }
+    return true;
+  };
+  if (!parse()) {
+    s->drop();
+    return false;
+  }
+
+  // external loaders are asked first so cached files are not decoded
+  driver->addExternalImageLoader(s);
+  storage_ = s;
+  return true;
+}
+
+bool workshop::texture_cache::contains(const std::string& name) const
+{
+  return storage_ && storage_->find(storage_->absolute(name)) >= 0;
+}
+
+irr::video::ITexture* workshop::texture_cache::get_texture(const std::string& name)
+{
+  if (!storage_) return nullptr;
+
+  // the driver names textures loaded from files by their absolute paths
+  const irr::io::path absolute_name = storage_->absolute(name);
+  irr::video::ITexture* texture = storage_->driver->findTexture(absolute_name);
+  if (texture) return texture;
+
+  const int index = storage_->find(absolute_name);
+  if (index < 0) return nullptr;
+
+  // the driver copies pixels so the image can use the cache memory
+  const texture_record& r = storage_->records[index];
+  const auto format = static_cast<irr::video::ECOLOR_FORMAT>(r.format);
+  const irr::core::dimension2d<irr::u32> size(r.width, r.height);
+  char* pixels = storage_->pixels(r);
+  irr::video::IImage* image = storage_->driver->createImageFromData(format, size, pixels, true, false);
+  if (!image) return nullptr;
+
+  // drivers read mipmap data down to 1x1, textures without it get generated mipmaps
+  char* mipmaps = r.levels > 1 && r.levels == level_count(size) ? pixels + pixels_size(format, size, 1) : nullptr;
+  texture = storage_->driver->addTexture(absolute_name, image, mipmaps);
+  image->drop();
+  return texture;
+}
+
+bool workshop::texture_cache::add(const std::string& name, irr::video::ITexture* texture)
+{
+  assert(texture);
+
+  const irr::video::ECOLOR_FORMAT format = texture->getColorFormat();
+  const irr::u32 bpp = bytes_per_pixel(format);
+  if (!bpp) return false;
+
+  const irr::core::dimension2d<irr::u32> size = texture->getSize();
+  const irr::u32 levels = texture->hasMipMaps() ? level_count(size) : 1;
+  baked_texture baked{name, format, size, levels, std::vector<char>(pixels_size(format, size, levels))};
+
+  char* out = baked.pixels.data();
+  irr::core::dimension2d<irr::u32> level_size = size;
+  for (irr::u32 i = 0; i < levels; ++i, level_size = next_level(level_size)) {
+    const char* in = static_cast<const char*>(texture->lock(irr::video::ETLM_READ_ONLY, i));
+    if (!in) {
+      if (i == 0) return false;
+      // mipmaps which cannot be read back are generated by the driver when the texture is created
+      baked.levels = 1;
+      baked.pixels.resize(pixels_size(format, size, 1));
+      break;
+    }
+
+    // rows of the first level may be padded, mipmap levels are tightly packed
+    const std::size_t row = static_cast<std::size_t>(level_size.Width) * bpp;
+    const std::size_t pitch = i == 0 ? texture->getPitch() : row;
+    for (irr::u32 y = 0; y < level_size.Height; ++y, out += row) std::memcpy(out, in + y * pitch, row);
+    texture->unlock();
+  }
+
+  baked_.push_back(std::move(baked));
+  return true;
+}
+
+bool workshop::texture_cache::add(const std::string& name, irr::video::IImage* image)
+{
+  assert(image);
+
+  const irr::video::ECOLOR_FORMAT format = image->getColorFormat();
+  const irr::u32 bpp = bytes_per_pixel(format);
+  if (!bpp) return false;
+
+  const irr::core::dimension2d<irr::u32> size = image->getDimension();
+  baked_texture baked{name, format, size, 1, std::vector<char>(pixels_size(format, size, 1))};
+
+  const char* in = static_cast<const char*>(image->lock());
+  if (!in) return false;
+  const std::size_t row = static_cast<std::size_t>(size.Width) * bpp;
+  char* out = baked.pixels.data();
+  for (irr::u32 y = 0; y < size.Height; ++y, out += row) std::memcpy(out, in + y * image->getPitch(), row);
+  image->unlock();
+
+  baked_.push_back(std::move(baked));
+  return true;
+}
+
+bool workshop::texture_cache::write(const std::string& path, irr::video::IVideoDriver* driver) const
+{
+  assert(driver);
+
+  std::vector<texture_record> records;
+  std::string names;
+  records.reserve(baked_.size());
+  for (const baked_texture& t : baked_) {
+    records.push_back({static_cast<irr::u32>(names.size()), static_cast<irr::u32>(t.name.size()),
+                       static_cast<irr::u32>(t.format), t.size.Width, t.size.Height, t.levels, 0,
+                       static_cast<irr::u32>(t.pixels.size())});
+    names += t.name;
+  }
+
+  header_record header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.driver = static_cast<irr::u32>(driver->getDriverType());
+  header.texture_count = static_cast<irr::u32>(records.size());
+  header.textures_offset = sizeof(header_record);
+  header.names_offset = static_cast<irr::u32>(header.textures_offset + records.size() * sizeof(texture_record));
+  header.names_size = static_cast<irr::u32>(names.size());
+
+  std::size_t offset = header.names_offset + names.size();
+  for (texture_record& r : records) {
+    r.pixels_offset = static_cast<irr::u32>(align(offset));
+    offset = r.pixels_offset + r.pixels_size;
+  }
+
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) return false;
+  bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+  if (written && !records.empty())
+    written = std::fwrite(records.data(), sizeof(texture_record), records.size(), file) == records.size();
+  if (written && !names.empty()) written = std::fwrite(names.data(), 1, names.size(), file) == names.size();
+
+  const char padding[pixels_alignment] = {};
+  offset = header.names_offset + names.size();
+  for (std::size_t i = 0; written && i < baked_.size(); ++i) {
+    const std::size_t padding_size = records[i].pixels_offset - offset;
+    if (padding_size) written = std::fwrite(padding, 1, padding_size, file) == padding_size;
+    const std::vector<char>& pixels = baked_[i].pixels;
+    if (written) written = std::fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+    offset = records[i].pixels_offset + records[i].pixels_size;
+  }
+  return std::fclose(file) == 0 && written;
+}
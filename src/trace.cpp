@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2019, Train IT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <irrlicht-engine/trace.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace {
+
+void write_escaped(std::ostream& os, const std::string& str)
+{
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        os << "\\\"";
+        break;
+      case '\\':
+        os << "\\\\";
+        break;
+      case '\n':
+        os << "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        else
+          os << c;
+    }
+  }
+}
+
+double microseconds(workshop::trace_log::clock::duration d)
+{
+  return std::chrono::duration<double, std::micro>(d).count();
+}
+
+}  // namespace
+
+/* ********************************* T R A C E ********************************* */
+
+workshop::trace_log& workshop::trace_log::instance()
+{
+  static trace_log instance;
+  return instance;
+}
+
+void workshop::trace_log::start()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.clear();
+  origin_ = clock::now();
+  enabled_ = true;
+}
+
+void workshop::trace_log::stop()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  enabled_ = false;
+}
+
+void workshop::trace_log::add(const char* name, const std::string& detail, clock::time_point begin,
+                              clock::time_point end)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!enabled_) return;
+  events_.push_back({name, detail, begin, end, std::this_thread::get_id()});
+}
+
+bool workshop::trace_log::write(const std::string& path) const
+{
+  std::ofstream file(path);
+  if (!file) return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // trace viewers expect small integer thread ids
+  std::vector<std::thread::id> threads;
+  auto tid = [&](std::thread::id id) {
+    auto it = std::find(threads.begin(), threads.end(), id);
+    if (it == threads.end()) it = threads.insert(threads.end(), id);
+    return static_cast<int>(it - threads.begin()) + 1;
+  };
+
+  file << "{\"traceEvents\":[";
+  bool first = true;
+  file << std::fixed << std::setprecision(3);
+  for (const event& e : events_) {
+    if (!first) file << ",";
+    first = false;
+    file << "\n{\"name\":\"";
+    write_escaped(file, e.name);
+    file << "\",\"cat\":\"engine\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid(e.thread)
+         << ",\"ts\":" << microseconds(e.begin - origin_) << ",\"dur\":" << microseconds(e.end - e.begin);
+    if (!e.detail.empty()) {
+      file << ",\"args\":{\"detail\":\"";
+      write_escaped(file, e.detail);
+      file << "\"}";
+    }
+    file << "}";
+  }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+  return static_cast<bool>(file);
+}
+
+workshop::trace_scope::trace_scope(const char* name) : name_(name), enabled_(trace_log::instance().enabled())
+{
+  if (enabled_) begin_ = trace_log::clock::now();
+}
+
+workshop::trace_scope::trace_scope(const char* name, const char* detail) :
+    trace_scope(name, [detail] { return std::string(detail ? detail : ""); })
+{
+}
+
+workshop::trace_scope::trace_scope(const char* name, const std::string& detail) :
+    trace_scope(name, [&detail] { return detail; })
+{
+}
+
+workshop::trace_scope::~trace_scope()
+{
+  if (enabled_) trace_log::instance().add(name_, detail_, begin_, trace_log::clock::now());
+}
@@ -97,6 +97,58 @@ bool workshop::counters::validate() const
   return !problemFound;
 }
 
+workshop::memory_counters& workshop::memory_counters::instance()
+{
+  static memory_counters instance;
+  return instance;
+}
+
+void workshop::memory_counters::allocated(int subsystem, std::size_t bytes)
+{
+  assert(0 <= subsystem && subsystem < num);
+
+  update_peak(subsystem, current_[subsystem].fetch_add(bytes) + bytes);
+}
+
+void workshop::memory_counters::deallocated(int subsystem, std::size_t bytes)
+{
+  assert(0 <= subsystem && subsystem < num);
+  assert(current_[subsystem] >= bytes);
+
+  current_[subsystem] -= bytes;
+}
+
+void workshop::memory_counters::update_peak(int subsystem, std::size_t bytes)
+{
+  std::size_t peak = peak_[subsystem];
+  while (peak < bytes && !peak_[subsystem].compare_exchange_weak(peak, bytes)) {
+  }
+}
+
+workshop::memory_counters::data workshop::memory_counters::get() const
+{
+  data result;
+  for (int i = 0; i < num; ++i) result[i] = {current_[i], peak_[i]};
+  return result;
+}
+
+void workshop::memory_counters::print() const
+{
+  const char* txt[] = {"Mesh cache", "Textures", "Level selector", "Object selectors", "Fonts", "Engine data",
+                       "Capture buffers"};
+  static_assert(std::size(txt) == num, "Memory descriptions table out of sync!");
+
+  std::cout << "\nMemory usage (current / peak in KiB):\n";
+  std::cout << "=====================================\n";
+  std::size_t overall = 0;
+  for (int i = 0; i < num; ++i) {
+    std::cout << "   " << std::setw(20) << std::left << txt[i] << " = " << current_[i] / 1024 << " / "
+              << peak_[i] / 1024 << "\n";
+    overall += current_[i];
+  }
+  std::cout << "   " << std::setw(20) << std::left << "Overall" << " = " << overall / 1024 << "\n";
+}
+
 void workshop::counters::print(bool detailed) const
 {
   assert(data_.size() == names_.size());